@@ -0,0 +1,34 @@
+#ifndef BOT_SENDER_H
+#define BOT_SENDER_H
+
+#include <Arduino.h>
+#include <UniversalTelegramBot.h>
+
+/* Replies waiting to be sent, and the largest text a reply carries.
+ * One getUpdates batch answers up to HANDLE_MESSAGES commands at once,
+ * the queue holds all their replies while the sender works on the first.
+ */
+#define BOT_SEND_QUEUE   (HANDLE_MESSAGES)
+#define BOT_REPLY_SIZE   (1024)
+/* Attempts per reply, waiting BOT_SEND_BACKOFF ms after the first failure
+ * and twice as long after each of the next ones */
+#define BOT_SEND_RETRIES (4)
+#define BOT_SEND_BACKOFF (1000)
+
+/* Create the reply queue. The bot must have its own client for outgoing
+ * messages (setSendClient) since vBotSenderTask sends while the message
+ * task polls.
+ */
+void botSenderBegin(UniversalTelegramBot*);
+
+/* Queue a reply without waiting. Text longer than BOT_REPLY_SIZE is cut
+ * at a UTF-8 character and the cut logged: the longest reply, /start,
+ * must fit.
+ * Returns false if the queue is full and the reply was dropped.
+ */
+bool queueReply(const char* chat_id, const char* text, const char* parse_mode);
+
+/* Sends the queued replies, retrying with backoff */
+void vBotSenderTask(void*);
+
+#endif /* !BOT_SENDER_H */
@@ -0,0 +1,45 @@
+#ifndef CHAMBER_H
+#define CHAMBER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "sampleExchange.h"
+#include "tempControl.h"
+
+/* One fermenter: its probes, relays, what the user chose and the control
+ * state. The table is defined in main.cpp; every chamber is read by the
+ * one shared conversion of vReadTempTask and stepped by the one
+ * vTempControl, nothing runs per chamber.
+ */
+typedef struct {
+  uint8_t        probe[SAMPLE_PROBES][8];  /* addresses, by PROBE_* */
+  uint8_t        heatPin, coolPin, fanPin;
+  ctrlSettings_t settings;  /* written by the bot, kept in pref */
+  ctrlState_t    state;     /* written by vTempControl only */
+  uint8_t        driven;    /* relays as last written, HIST_* bits */
+  Preferences    pref;
+} chamber_t;
+
+/* Setpoints are kept within this range, °C */
+#define SETPOINT_MIN (0)
+#define SETPOINT_MAX (40)
+
+extern chamber_t     chambers[];
+extern const uint8_t numChambers;
+
+/* Relays off and settings loaded from the namespace of chamber 'index':
+ * "temp" for the first one, as before there were several, then "temp2",
+ * "temp3"... A stored setpoint out of range is replaced by its default.
+ */
+void chamberBegin(chamber_t*, uint8_t index);
+
+/* Write the relays whose state changed since the last call. Those going
+ * off are released first so cooling and heating never overlap when the
+ * mode flips in one step.
+ */
+void chamberDriveRelays(chamber_t*);
+
+/* HIST_FAN | HIST_COOL | HIST_HEAT as decided by the last control step */
+uint8_t chamberRelays(const chamber_t*);
+
+#endif /* !CHAMBER_H */
@@ -0,0 +1,51 @@
+#ifndef FERMENT_LOG_H
+#define FERMENT_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "tempHistory.h"
+
+/* Append only log of the one minute history entries, kept on a flash
+ * file system in FLOG_SEGMENTS rotating segment files. Entries are
+ * buffered and written FLOG_BATCH at a time as one delta compressed,
+ * CRC checked record, so the flash sees one small write every
+ * FLOG_BATCH minutes. Up to FLOG_BATCH - 1 minutes are lost on reset.
+ */
+#define FLOG_DIR      "/flog"
+#define FLOG_SEGMENTS (4)
+#define FLOG_SEG_SIZE (65536)
+#define FLOG_BATCH    (30)
+
+/* Open the log on fs (LittleFS on the board) and find where it ends.
+ * Only the newest segment is scanned. Returns false if the file system
+ * can't be used, the log then stays disabled.
+ */
+bool fermentLogBegin(fs::FS&);
+
+/* Log the entry of 'minute' (unix time / 60). A minute that doesn't
+ * follow the previous one starts a new record.
+ */
+void fermentLogAppend(uint32_t minute, const historyPoint_t*);
+
+/* historySink_t logging every history entry, see historySetSink(). Each
+ * entry gets the minute after the previous one, so none is logged twice
+ * or left out. The count starts from the clock once NTP answered and is
+ * set back on it when the minute of an entry's stamp is more than
+ * FLOG_DRIFT minutes away.
+ */
+#define FLOG_DRIFT (2)
+void fermentLogSink(const historyPoint_t*, unsigned long stamp, void* arg);
+
+/* Write the buffered entries now */
+void fermentLogFlush(void);
+
+/* Minute of the last entry written or buffered, 0 if none */
+uint32_t fermentLogLastMinute(void);
+
+/* Call visit for every logged entry from 'fromMinute' on, oldest first.
+ * Returns the number of entries visited.
+ */
+typedef void (*flogVisitor_t)(uint32_t minute, const historyPoint_t*, void* arg);
+uint32_t fermentLogReplay(uint32_t fromMinute, flogVisitor_t visit, void* arg);
+
+#endif /* !FERMENT_LOG_H */
@@ -0,0 +1,82 @@
+#ifndef PID_CONTROL_H
+#define PID_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Cascade used by MODE_PID: the outer loop drives the liquid toward its
+ * setpoint by choosing the chamber setpoint, the inner loop drives the
+ * chamber toward it through a duty in -1 (full cooling) .. 1 (full
+ * heating), which a time proportioned output turns into relay windows.
+ * Everything here is plain computation, the caller owns time and relays.
+ */
+
+/* Outer loop: °C of liquid error -> °C of chamber offset */
+#define PID_OUTER_KP   (4.0)
+#define PID_OUTER_KI   (4.0 / 1800)   /* per °C·s */
+#define PID_OUTER_SPAN (8.0)          /* chamber setpoint within ±8 °C of the liquid's */
+#define PID_OUTER_BAND (0.25)         /* °C of liquid error without heating or cooling */
+/* Inner loop: °C of chamber error -> duty */
+#define PID_INNER_KP   (0.4)
+#define PID_INNER_KI   (0.4 / 600)
+#define PID_INNER_KD   (0.0)
+/* Relay windows */
+#define PID_PERIOD     (900000)       /* ms per window */
+#define PID_MIN_ON     (60000)        /* shorter on times are skipped */
+#define PID_DEADBAND   (0.15)         /* smaller duties leave the window off */
+#define PID_LOCKOUT    (PID_PERIOD)   /* ms off before the other direction */
+
+typedef struct {
+  float kp, ki, kd;
+  float outMin, outMax;
+  float integral;
+  float lastPv;
+  bool  primed;     /* lastPv holds a value */
+} pidLoop_t;
+
+void  pidInit(pidLoop_t*, float kp, float ki, float kd, float outMin, float outMax);
+void  pidReset(pidLoop_t*);
+/* One step, dt in seconds. Derivative on the measurement, the integral
+ * stops growing while the output is saturated.
+ */
+float pidUpdate(pidLoop_t*, float setpoint, float pv, float dt);
+
+/* Time proportioned output. The duty is latched when a window starts and
+ * the output is on for |duty| of the window. Around zero duty there is a
+ * deadband, and the output changes direction only after it was off for
+ * lockout ms, so heating and cooling don't take turns fighting each other.
+ */
+typedef struct {
+  unsigned long period;
+  unsigned long minOn;
+  float         deadband;
+  unsigned long lockout;
+  unsigned long start;
+  unsigned long onMs;
+  int8_t        dir;      /* sign of the latched duty, 0 for an idle window */
+  int8_t        lastDir;  /* direction of the last window that was on */
+  unsigned long lastEnd;  /* when its on time ended */
+  bool          started;
+} tpo_t;
+
+void   tpoInit(tpo_t*, unsigned long period, unsigned long minOn, float deadband,
+               unsigned long lockout);
+/* Returns the latched duty sign while on, 0 while off */
+int8_t tpoUpdate(tpo_t*, float duty, unsigned long now);
+
+typedef struct {
+  pidLoop_t outer;
+  pidLoop_t inner;
+  tpo_t     out;
+  float     chamberSp;  /* last setpoint chosen by the outer loop */
+  float     duty;
+} cascade_t;
+
+void  cascadeInit(cascade_t*);
+/* Duty for the liquid setpoint, dt in seconds since the last call. While
+ * the liquid is within PID_OUTER_BAND on the wrong side the duty is 0 and
+ * the inner integral holds.
+ */
+float cascadeUpdate(cascade_t*, float liquidSp, float liquid, float chamber, float dt);
+
+#endif /* !PID_CONTROL_H */
@@ -0,0 +1,48 @@
+#ifndef PROBE_SCAN_H
+#define PROBE_SCAN_H
+
+#include <Arduino.h>
+#include "chamber.h"
+
+/* Background enumeration of the bus. vProbeScanTask runs the ROM search
+ * one ROM at a time, PROBE_SCAN_SLICE ms apart, so the reader never waits
+ * more than one search step for the bus. Each pass updates a small table
+ * of the ROMs seen; a probe missing for PROBE_MISS_LIMIT passes is gone.
+ *
+ * Roles are chamber * SAMPLE_PROBES + PROBE_*. The address of each role
+ * lives in the chamber table and is stored in Preferences when it
+ * changes, so it overrides tokens.h from then on. When a pass ends with
+ * exactly one role whose probe is gone and exactly one unassigned probe
+ * present, the new probe takes that role: a probe is swapped without
+ * touching the firmware.
+ */
+#define PROBE_SLOTS       (8)      /* ROMs tracked */
+#define PROBE_SCAN_SLICE  (500)    /* ms between two search steps */
+#define PROBE_SCAN_PERIOD (30000)  /* ms between the start of two passes */
+#define PROBE_MISS_LIMIT  (2)
+#define PROBE_NO_ROLE     (0xFF)
+#define PROBE_ROLES       (SAMPLE_CHANNELS * SAMPLE_PROBES)
+
+typedef struct {
+  uint8_t rom[8];
+  uint8_t role;    /* PROBE_NO_ROLE if unassigned */
+  uint8_t missed;  /* passes since last seen, PROBE_MISS_LIMIT or more: gone */
+  bool    used;
+} probeSlot_t;
+
+/* Apply the stored roles to the chamber table. Call after chamberBegin()
+ * and before the reader starts.
+ */
+void probeScanBegin(void);
+
+/* Copy the slot table, PROBE_SLOTS entries */
+void probeScanList(probeSlot_t*);
+
+/* Give the probe of a slot a role, and store it. Returns false if the
+ * slot is empty, its probe is gone or the role doesn't exist.
+ */
+bool probeAssign(uint8_t slot, uint8_t role);
+
+void vProbeScanTask(void*);
+
+#endif /* !PROBE_SCAN_H */
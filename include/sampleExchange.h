@@ -0,0 +1,39 @@
+#ifndef SAMPLE_EXCHANGE_H
+#define SAMPLE_EXCHANGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Probe values carried by a sample */
+#define SAMPLE_PROBES  (2)
+#define PROBE_CHAMBER  (0)
+#define PROBE_LIQUID   (1)
+/* Independent samples exchanged, one per chamber */
+#define SAMPLE_CHANNELS (3)
+
+/* Every probe value of one conversion cycle */
+typedef struct {
+  float    temp[SAMPLE_PROBES];
+  uint32_t stamp;  /* millis() when the scratchpads were collected */
+  uint32_t valid;  /* SAMPLE_VALID(p) set for each probe p that answered */
+} tempSample_t;
+
+#define SAMPLE_VALID(p) (1u << (p))
+#define SAMPLE_ALL      ((1u << SAMPLE_PROBES) - 1)
+
+/* Publish a new sample on a channel. There must be a single writer
+ * (vReadTempTask) */
+void publishSample(uint8_t channel, const tempSample_t*);
+
+/* Copy the latest sample of a channel without taking any lock.
+ * Returns the number of samples published there so far, 0 means the
+ * copy holds no data yet.
+ */
+uint32_t readSample(uint8_t channel, tempSample_t*);
+
+/* True if every probe of 'probes', SAMPLE_VALID bits, answered and the
+ * sample is not older than maxAge ms */
+bool sampleIsFresh(const tempSample_t*, uint32_t probes, unsigned long now,
+                   unsigned long maxAge);
+
+#endif /* !SAMPLE_EXCHANGE_H */
@@ -7,6 +7,17 @@
 // Data wire is connected to GPIO 4
 #define ONE_WIRE_BUS 4
 
+/* Clock the bus with the RMT peripheral instead of busy waiting on the
+ * CPU, see OneWireRmt.h. Needs ONEWIRE_BACKEND. Off until the driver has
+ * been run on a board: add -DONEWIRE_RMT=1 to its build_flags to try it.
+ */
+#ifndef ONEWIRE_RMT
+#define ONEWIRE_RMT 0
+#endif
+#if ONEWIRE_RMT
+#include <OneWireRmt.h>
+#endif
+
 /* Init one wire for ds18b20 */
 void setupSensorsOnOneWire();
 
@@ -25,6 +36,75 @@ String readDSTempStringC(uint8_t);
  */
 String readDSTempStringCByAdd(uint8_t*);
 
+/* Adaptive sampling. For DS_BOOST_MS after a relay switched or a probe
+ * moved DS_FAST_DELTA or more within DS_SLOPE_WINDOW, the reader asks the
+ * probes for DS_RES_FAST bits and samples at its fast rate. Otherwise it
+ * goes back to DS_RES_SLOW bits at its slow rate. The resolution is set
+ * through DallasTemperature's cache and never saved to EEPROM: a probe
+ * that already has it costs no bus time.
+ */
+#define DS_RES_FAST      (9)       /* 94 ms conversions, 0.5 °C steps */
+#define DS_RES_SLOW      (12)      /* 750 ms conversions, 0.0625 °C steps */
+#define DS_BOOST_MS      (60000)
+#define DS_SLOPE_WINDOW  (60000)
+#define DS_FAST_DELTA    (96)      /* raw, 0.75 °C: two steps at DS_RES_FAST */
+#define DS_READER_PROBES (8)       /* most probes one reader follows */
+
+/* Non blocking conversion pipeline states */
+typedef enum {
+  DS_READ_IDLE,       /* nothing requested yet */
+  DS_READ_CONVERTING, /* skip-ROM convert T issued, probes busy */
+  DS_READ_COLLECT     /* conversion time elapsed, scratchpads pending */
+} dsReadState_t;
+
+/* State machine reading a fixed set of probes with one shared conversion */
+typedef struct {
+  dsReadState_t  state;
+  uint8_t        count;    /* number of probes */
+  uint8_t      **addrs;    /* probe addresses */
+  DeviceAddress *roms;     /* addrs copied for DallasTemperature::readAll() */
+  int16_t       *raws;     /* last collected value per probe, 1/128 °C or
+                            * DEVICE_DISCONNECTED_RAW */
+  unsigned long  started;  /* millis() when conversion was requested */
+  unsigned long  convMs;   /* conversion time for the probes' resolution */
+  unsigned long  fastMs;   /* minimum time between samples, boosted */
+  unsigned long  slowMs;   /* minimum time between samples, steady */
+  uint8_t        resolution;  /* bits asked of the probes */
+  bool           boosted;
+  unsigned long  boostStart;
+  uint32_t       boostsSeen;  /* dsReaderBoost() calls handled */
+  bool           refTaken;
+  unsigned long  refStamp;    /* when ref was taken */
+  int16_t        ref[DS_READER_PROBES];  /* raws DS_SLOPE_WINDOW ago */
+} dsReader_t;
+
+/* Bind a reader to probe addresses, their copy and output values, with
+ * the fast and slow minimum times between samples. At most
+ * DS_READER_PROBES probes.
+ */
+void dsReaderInit(dsReader_t*, uint8_t**, DeviceAddress*, int16_t*, uint8_t,
+                  unsigned long, unsigned long);
+
+/* A relay switched: sample fast for a while. Any task may call it. */
+void dsReaderBoost(void);
+
+/* Advance the reader. Returns true when raws holds a fresh sample.
+ * waitMs is set to the time the caller can sleep before stepping again.
+ */
+bool dsReaderStep(dsReader_t*, unsigned long, unsigned long*);
+
+/* The reader and the probe scan share the bus, each holds it for one
+ * step. Created by setupSensorsOnOneWire().
+ */
+void dsBusTake(void);
+void dsBusGive(void);
+
+/* One step of the ROM search, see OneWire::search(). Returns false at
+ * the end of a pass, the next call starts a new one. Holds the bus, and
+ * on parasite power first waits for the reader's conversion to end.
+ */
+bool dsSearchStep(uint8_t* rom);
+
 /* Call sensors.getDeviceCount() */
 int getSensorCount();
 
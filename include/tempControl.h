@@ -0,0 +1,55 @@
+#ifndef TEMP_CONTROL_H
+#define TEMP_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sampleExchange.h"
+#include "pidControl.h"
+
+/* Relay decisions of vTempControl. Plain computation on a state, the
+ * settings and the latest sample: the caller owns time (ms), relays and
+ * waiting, so the same code runs on the board and in the simulator.
+ */
+
+#define MODE_OFF  (0)
+#define MODE_AUTO (1)
+#define MODE_HEAT (2)
+#define MODE_COOL (3)
+#define MODE_PID  (4)  /* cascade on the liquid probe, see pidControl.h */
+#define UNDEFINED (0)
+#define HEATING   (1)
+#define COOLING   (2)
+#define COOL_WAIT (120000)  /* ms the compressor stays off before restarting */
+#define FAN_WAIT  (300000)  /* ms the fan keeps blowing after heating/cooling */
+#define SAMPLE_MAX_AGE (5000)
+#define CTRL_WAIT_FOREVER (0xFFFFFFFF)
+
+/* What the user chose */
+typedef struct {
+  uint8_t selectedMode;
+  float   tempH, tempHH, tempL, tempLL;
+} ctrlSettings_t;
+
+typedef struct {
+  uint8_t   currentMode;
+  bool      cooling, heating, blowing;
+  bool      canRestart, canStopFan;
+  uint32_t  timeOff;     /* ms when heating or cooling last stopped */
+  cascade_t cascade;     /* MODE_PID only */
+  bool      pidActive;
+  uint32_t  pidStamp;    /* stamp of the sample the cascade last saw */
+} ctrlState_t;
+
+void controlInit(ctrlState_t*, uint32_t now);
+
+/* Decide the relays for the sample at time now. A stale sample is marked
+ * invalid; an unknown mode falls back to MODE_OFF in the settings.
+ */
+void controlStep(ctrlState_t*, ctrlSettings_t*, tempSample_t*, uint32_t now);
+
+/* ms until a compressor/fan timer expires or the sample goes stale,
+ * CTRL_WAIT_FOREVER if nothing is pending
+ */
+uint32_t controlTimeout(const ctrlState_t*, const tempSample_t*, uint32_t now);
+
+#endif /* !TEMP_CONTROL_H */
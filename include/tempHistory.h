@@ -0,0 +1,63 @@
+#ifndef TEMP_HISTORY_H
+#define TEMP_HISTORY_H
+
+#include <Arduino.h>
+#include "sampleExchange.h"
+
+/* One entry per HISTORY_PERIOD ms. HISTORY_LEN is a multiple of
+ * HISTORY_BLOCK and keeps at least 7 days at one entry per minute, the
+ * entries of the oldest, partly overwritten block are not readable.
+ */
+#define HISTORY_PERIOD (60000)
+#define HISTORY_BLOCK  (64)
+#define HISTORY_LEN    (159 * HISTORY_BLOCK)
+
+/* Entry flags */
+#define HIST_FAN      (1 << 0)
+#define HIST_COOL     (1 << 1)
+#define HIST_HEAT     (1 << 2)
+#define HIST_INVALID0 (1 << 3)  /* probe 0 gave no reading, see HIST_INVALID() */
+#define HIST_INVALID(probe) (HIST_INVALID0 << (probe))
+
+/* An entry as read back */
+typedef struct {
+  float   temp[SAMPLE_PROBES];
+  uint8_t flags;
+} historyPoint_t;
+
+/* Create the lock, call before any other history function */
+void historyBegin(void);
+
+/* Record the sample and the relays (HIST_FAN | HIST_COOL | HIST_HEAT)
+ * once every HISTORY_PERIOD ms, call it as often as wanted. Periods
+ * missed since the last entry are recorded as invalid.
+ */
+void historyRecord(const tempSample_t*, uint8_t relays, unsigned long now);
+
+/* Called for every entry historyRecord() adds, missed periods included,
+ * in order and with the values as stored. stamp is the millis() the entry
+ * stands for. It runs in the recording task with the history locked, so
+ * it must not call history functions.
+ */
+typedef void (*historySink_t)(const historyPoint_t*, unsigned long stamp, void* arg);
+void historySetSink(historySink_t, void* arg);
+
+/* Append an entry recovered from elsewhere (the flash log), one period
+ * before the first historyRecord() entry. Only before recording starts.
+ */
+void historyRestore(const historyPoint_t*);
+
+/* Number of readable entries */
+uint32_t historyCount(void);
+
+/* Copy up to n entries starting 'first' entries after the oldest one.
+ * Returns the number copied.
+ */
+uint32_t historyRead(uint32_t first, historyPoint_t*, uint32_t n);
+
+/* Copy the entry 'back' entries before the newest one (0 = newest).
+ * Returns false if there is no such entry.
+ */
+bool historyPointAgo(uint32_t back, historyPoint_t*);
+
+#endif /* !TEMP_HISTORY_H */
@@ -0,0 +1,36 @@
+#ifndef TEMP_STATS_H
+#define TEMP_STATS_H
+
+#include <Arduino.h>
+#include "sampleExchange.h"
+
+/* Rolling windows, each made of STATS_BUCKETS finished buckets plus the
+ * one being filled */
+#define STATS_WINDOWS (3)
+#define STATS_1M      (0)  /* 1 s buckets */
+#define STATS_1H      (1)  /* 1 min buckets */
+#define STATS_24H     (2)  /* 24 min buckets */
+#define STATS_BUCKETS (60)
+
+typedef struct {
+  uint32_t count;  /* samples in the window, 0 means no data */
+  float    min;
+  float    max;
+  float    mean;
+  float    slope;  /* least squares trend, °C per hour */
+} tempStats_t;
+
+/* Create the lock, call before any other stats function */
+void statsBegin(void);
+
+/* Add a sample to every window, O(1) amortized. Probes that didn't
+ * answer are skipped. There must be a single writer (vReadTempTask).
+ */
+void statsAdd(const tempSample_t*);
+
+/* Current figures of a window for one probe. Returns false if the
+ * window holds no sample.
+ */
+bool statsGet(uint8_t window, uint8_t probe, tempStats_t*);
+
+#endif /* !TEMP_STATS_H */
@@ -14,6 +14,7 @@ extern "C" {
 #endif
 
 // OneWire commands
+#define MATCHROM        0x55  // Address one device by its ROM code
 #define STARTCONVO      0x44  // Tells device to take a temperature reading and put it on the scratchpad
 #define COPYSCRATCH     0x48  // Copy scratchpad to EEPROM
 #define READSCRATCH     0xBE  // Read from scratchpad
@@ -98,6 +99,7 @@ void DallasTemperature::setOneWire(OneWire* _oneWire) {
 	waitForConversion = true;
 	checkForConversion = true;
   autoSaveScratchPad = true;
+	invalidateCache();
 
 }
 
@@ -109,6 +111,7 @@ void DallasTemperature::begin(void) {
 	_wire->reset_search();
 	devices = 0; // Reset the number of devices when we enumerate wire devices
 	ds18Count = 0; // Reset number of DS18xxx Family devices
+	invalidateCache();
 
 	while (_wire->search(deviceAddress)) {
 
@@ -118,11 +121,16 @@ void DallasTemperature::begin(void) {
 			if (validFamily(deviceAddress)) {
 				ds18Count++;
 
-				if (!parasite && readPowerSupply(deviceAddress))
+				// the power mode of each device is kept, not only the bus one
+				bool deviceParasite = readPowerSupply(deviceAddress);
+				if (deviceParasite)
 					parasite = true;
 
 				uint8_t b = getResolution(deviceAddress);
 				if (b > bitResolution) bitResolution = b;
+
+				CachedDevice* cached = findCached(deviceAddress);
+				if (cached != nullptr) cached->parasite = deviceParasite;
 			}
 		}
 	}
@@ -179,15 +187,14 @@ bool DallasTemperature::isConnected(const uint8_t* deviceAddress,
 bool DallasTemperature::readScratchPad(const uint8_t* deviceAddress,
 		uint8_t* scratchPad) {
 
-	// send the reset command and fail fast
-	int b = _wire->reset();
-	if (b == 0)
-		return false;
+	// reset, select and command go out with the read as one transaction
+	// of the bus, which fails fast if the reset gets no answer
+	uint8_t command[10];
+	command[0] = MATCHROM;
+	memcpy(command + 1, deviceAddress, 8);
+	command[9] = READSCRATCH;
 
-	_wire->select(deviceAddress);
-	_wire->write(READSCRATCH);
-
-	// Read all registers in a simple loop
+	// Read all registers at once
 	// byte 0: temperature LSB
 	// byte 1: temperature MSB
 	// byte 2: high alarm temp
@@ -200,11 +207,10 @@ bool DallasTemperature::readScratchPad(const uint8_t* deviceAddress,
 	// byte 7: DS18S20: COUNT_PER_C
 	//         DS18B20 & DS1822: store for crc
 	// byte 8: SCRATCHPAD_CRC
-	for (uint8_t i = 0; i < 9; i++) {
-		scratchPad[i] = _wire->read();
-	}
+	if (!_wire->transaction(true, command, sizeof(command), scratchPad, 9))
+		return false;
 
-	b = _wire->reset();
+	int b = _wire->reset();
 	return (b == 1);
 }
 
@@ -248,6 +254,71 @@ bool DallasTemperature::readPowerSupply(const uint8_t* deviceAddress)
 	return parasiteMode;
 }
 
+// resolution coded in a configuration register, 0 if it is not one
+static uint8_t configResolution(uint8_t configuration) {
+	switch (configuration) {
+	case TEMP_12_BIT:
+		return 12;
+	case TEMP_11_BIT:
+		return 11;
+	case TEMP_10_BIT:
+		return 10;
+	case TEMP_9_BIT:
+		return 9;
+	}
+	return 0;
+}
+
+// returns the cache entry of a device, nullptr if it has none
+DallasTemperature::CachedDevice* DallasTemperature::findCached(const uint8_t* deviceAddress) {
+	for (uint8_t i = 0; i < DEVICECACHESIZE; i++) {
+		if (deviceCache[i].resolution != 0 &&
+			memcmp(deviceCache[i].address, deviceAddress, sizeof(DeviceAddress)) == 0)
+			return &deviceCache[i];
+	}
+	return nullptr;
+}
+
+// stores the resolution of a device, taking a free entry or the oldest one
+// for a device not cached yet. Its power mode is assumed to be the bus one
+// until begin() reads it.
+DallasTemperature::CachedDevice* DallasTemperature::cacheDevice(const uint8_t* deviceAddress,
+		uint8_t resolution) {
+	CachedDevice* cached = findCached(deviceAddress);
+
+	for (uint8_t i = 0; i < DEVICECACHESIZE && cached == nullptr; i++) {
+		if (deviceCache[i].resolution == 0) cached = &deviceCache[i];
+	}
+	if (cached == nullptr) {
+		cached = &deviceCache[deviceCacheNext];
+		deviceCacheNext = (deviceCacheNext + 1) % DEVICECACHESIZE;
+	}
+	if (cached->resolution == 0 ||
+		memcmp(cached->address, deviceAddress, sizeof(DeviceAddress)) != 0) {
+		memcpy(cached->address, deviceAddress, sizeof(DeviceAddress));
+		cached->parasite = parasite;
+	}
+	cached->resolution = resolution;
+	return cached;
+}
+
+// takes the resolution from a scratchpad just read
+void DallasTemperature::cacheScratchPad(const uint8_t* deviceAddress, const uint8_t* scratchPad) {
+	if (deviceAddress[DSROM_FAMILY] == DS18S20MODEL) return;
+	uint8_t b = configResolution(scratchPad[CONFIGURATION]);
+	if (b != 0) cacheDevice(deviceAddress, b);
+}
+
+void DallasTemperature::invalidateCache(const uint8_t* deviceAddress) {
+	if (deviceAddress == nullptr) {
+		for (uint8_t i = 0; i < DEVICECACHESIZE; i++) deviceCache[i].resolution = 0;
+		deviceCacheNext = 0;
+		return;
+	}
+	CachedDevice* cached = findCached(deviceAddress);
+	if (cached != nullptr) cached->resolution = 0;
+}
+
 // set resolution of all devices to 9, 10, 11, or 12 bits
 // if new resolution is out of range, it is constrained.
 void DallasTemperature::setResolution(uint8_t newResolution) {
@@ -281,9 +352,15 @@ bool DallasTemperature::setResolution(const uint8_t* deviceAddress,
     newResolution = constrain(newResolution, 9, 12);
     uint8_t newValue = 0;
     ScratchPad scratchPad;
+    CachedDevice* cached = findCached(deviceAddress);
 
+    // a device known to have it already is left alone
+    if (cached != nullptr && cached->resolution == newResolution)
+    {
+      success = true;
+    }
     // we can only update the sensor if it is connected
-    if (isConnected(deviceAddress, scratchPad))
+    else if (isConnected(deviceAddress, scratchPad))
     {
       switch (newResolution) {
         case 12:
@@ -307,9 +384,14 @@ bool DallasTemperature::setResolution(const uint8_t* deviceAddress,
 		scratchPad[CONFIGURATION] = newValue;
         writeScratchPad(deviceAddress, scratchPad);
       }
+      cacheDevice(deviceAddress, newResolution);
       // done
       success = true;
     }
+    else
+    {
+      invalidateCache(deviceAddress);
+    }
   }
 
   // do we need to update the max resolution used?
@@ -318,11 +400,13 @@ bool DallasTemperature::setResolution(const uint8_t* deviceAddress,
     bitResolution = newResolution;
     if (devices > 1)
     {
-      for (uint8_t i = 0; i < devices; i++)
+      // one search pass over the devices on the bus now, hot-plugged ones
+      // included; only those not cached have their scratchpad read
+      DeviceAddress deviceAddr;
+      _wire->reset_search();
+      while (bitResolution < 12 && _wire->search(deviceAddr))
       {
-        if (bitResolution == 12) break;
-        DeviceAddress deviceAddr;
-        getAddress(deviceAddr, i);
+        if (!validAddress(deviceAddr) || !validFamily(deviceAddr)) continue;
         uint8_t b = getResolution(deviceAddr);
         if (b > bitResolution) bitResolution = b;
       }
@@ -340,27 +424,22 @@ uint8_t DallasTemperature::getResolution() {
 
 // returns the current resolution of the device, 9-12
 // returns 0 if device not found
+// a cached device is not read again
 uint8_t DallasTemperature::getResolution(const uint8_t* deviceAddress) {
 
 	// DS1820 and DS18S20 have no resolution configuration register
 	if (deviceAddress[DSROM_FAMILY] == DS18S20MODEL)
 		return 12;
 
+	CachedDevice* cached = findCached(deviceAddress);
+	if (cached != nullptr)
+		return cached->resolution;
+
 	ScratchPad scratchPad;
 	if (isConnected(deviceAddress, scratchPad)) {
-		switch (scratchPad[CONFIGURATION]) {
-		case TEMP_12_BIT:
-			return 12;
-
-		case TEMP_11_BIT:
-			return 11;
-
-		case TEMP_10_BIT:
-			return 10;
-
-		case TEMP_9_BIT:
-			return 9;
-		}
+		uint8_t b = configResolution(scratchPad[CONFIGURATION]);
+		if (b != 0) cacheDevice(deviceAddress, b);
+		return b;
 	}
 	return 0;
 
@@ -415,6 +494,8 @@ void DallasTemperature::requestTemperatures() {
 // sends command for one device to perform a temperature by address
 // returns FALSE if device is disconnected
 // returns TRUE  otherwise
+// a cached device is taken as connected until a read of it fails, so the
+// conversion starts without reading its scratchpad first
 bool DallasTemperature::requestTemperaturesByAddress(
 		const uint8_t* deviceAddress) {
 
@@ -423,9 +504,10 @@ bool DallasTemperature::requestTemperaturesByAddress(
 		return false; //Device disconnected
 	}
 
+	CachedDevice* cached = findCached(deviceAddress);
 	_wire->reset();
 	_wire->select(deviceAddress);
-	_wire->write(STARTCONVO, parasite);
+	_wire->write(STARTCONVO, cached != nullptr ? cached->parasite : parasite);
 
 	// ASYNC mode?
 	if (!waitForConversion)
@@ -646,15 +728,55 @@ int16_t DallasTemperature::calculateTemperature(const uint8_t* deviceAddress,
 // the numeric value of DEVICE_DISCONNECTED_RAW is defined in
 // DallasTemperature.h. It is a large negative number outside the
 // operating range of the device
+// one scratchpad read, its CRC checked; it refreshes the cached resolution,
+// a failed one drops the device from the cache
 int16_t DallasTemperature::getTemp(const uint8_t* deviceAddress) {
 
 	ScratchPad scratchPad;
-	if (isConnected(deviceAddress, scratchPad))
+	if (isConnected(deviceAddress, scratchPad)) {
+		cacheScratchPad(deviceAddress, scratchPad);
 		return calculateTemperature(deviceAddress, scratchPad);
+	}
+	invalidateCache(deviceAddress);
 	return DEVICE_DISCONNECTED_RAW;
 
 }
 
+// one transaction per device: the reset that starts the next read ends
+// the previous one, so the bus is reset once more only at the end.
+// The CRC is checked with OneWire's lookup table (ONEWIRE_CRC8_TABLE).
+uint8_t DallasTemperature::readAll(const DeviceAddress* deviceAddresses,
+		uint8_t count, int16_t* raw) {
+
+	uint8_t command[10];
+	ScratchPad scratchPad;
+	uint8_t good = 0;
+
+	if (count == 0)
+		return 0;
+
+	command[0] = MATCHROM;
+	command[9] = READSCRATCH;
+	for (uint8_t i = 0; i < count; i++) {
+		const uint8_t* deviceAddress = deviceAddresses[i];
+
+		memcpy(command + 1, deviceAddress, 8);
+		if (_wire->transaction(true, command, sizeof(command), scratchPad, 9)
+				&& !isAllZeros(scratchPad)
+				&& _wire->crc8(scratchPad, 8) == scratchPad[SCRATCHPAD_CRC]) {
+			cacheScratchPad(deviceAddress, scratchPad);
+			raw[i] = calculateTemperature(deviceAddress, scratchPad);
+			good++;
+		} else {
+			invalidateCache(deviceAddress);
+			raw[i] = DEVICE_DISCONNECTED_RAW;
+		}
+	}
+	_wire->reset();
+	return good;
+
+}
+
 // returns temperature in degrees C or DEVICE_DISCONNECTED_C if the
 // device's scratch pad cannot be read successfully.
 // the numeric value of DEVICE_DISCONNECTED_C is defined in
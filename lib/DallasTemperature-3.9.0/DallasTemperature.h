@@ -18,6 +18,11 @@
 #define REQUIRESALARMS true
 #endif
 
+// number of devices whose resolution and power mode are cached, at least 1
+#ifndef DEVICECACHESIZE
+#define DEVICECACHESIZE 8
+#endif
+
 #include <inttypes.h>
 #ifdef __STM32F1__
 #include <OneWireSTM.h>
@@ -107,6 +112,10 @@ public:
 	// read device's power requirements
 	bool readPowerSupply(const uint8_t* deviceAddress = nullptr);
 
+	// forget what is cached about a device, or about every device if none
+	// is given. Failed reads do it on their own.
+	void invalidateCache(const uint8_t* deviceAddress = nullptr);
+
 	// get global resolution
 	uint8_t getResolution();
 
@@ -114,6 +123,7 @@ public:
 	void setResolution(uint8_t);
 
 	// returns the device resolution: 9, 10, 11, or 12 bits
+	// served from the cache when the device is in it
 	uint8_t getResolution(const uint8_t*);
 
 	// set resolution of a device to 9, 10, 11, or 12 bits
@@ -140,6 +150,11 @@ public:
 	// returns temperature raw value (12 bit integer of 1/128 degrees C)
 	int16_t getTemp(const uint8_t*);
 
+	// reads the scratchpads of several devices in one sweep of the bus and
+	// stores their raw values, DEVICE_DISCONNECTED_RAW for a device that
+	// didn't answer or failed the CRC. Returns the number of good reads.
+	uint8_t readAll(const DeviceAddress*, uint8_t, int16_t*);
+
 	// returns temperature in degrees C
 	float getTempC(const uint8_t*);
 
@@ -289,6 +304,23 @@ private:
 	// Take a pointer to one wire instance
 	OneWire* _wire;
 
+	// what begin(), getResolution(), setResolution() and every good
+	// scratchpad read learnt about a device, so steady state reads only
+	// touch the bus for the conversion and the scratchpad. The family is
+	// the first byte of the address and needs no entry.
+	typedef struct {
+		DeviceAddress address;
+		uint8_t resolution; // 9-12, 0 if the entry is free
+		bool parasite;
+	} CachedDevice;
+
+	CachedDevice deviceCache[DEVICECACHESIZE];
+	uint8_t deviceCacheNext; // entry replaced when every one is taken
+
+	CachedDevice* findCached(const uint8_t*);
+	CachedDevice* cacheDevice(const uint8_t*, uint8_t);
+	void cacheScratchPad(const uint8_t*, const uint8_t*);
+
 	// reads scratchpad and returns the raw temperature
 	int16_t calculateTemperature(const uint8_t*, uint8_t*);
 
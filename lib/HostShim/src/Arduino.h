@@ -0,0 +1,97 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/* The part of the Arduino-ESP32 core the firmware and its libraries use,
+ * for builds on the host (pio run -e host). Time is virtual and owned by
+ * the scheduler in hostScheduler.cpp, see hostShim.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <ctype.h>
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH   (1)
+#define LOW    (0)
+#define INPUT  (0x01)
+#define OUTPUT (0x03)
+#define INPUT_PULLUP (0x05)
+
+#define DEC (10)
+#define HEX (16)
+#define OCT (8)
+#define BIN (2)
+
+/* flash is ordinary memory here */
+#define PROGMEM
+#define IRAM_ATTR
+#define PSTR(s)            (s)
+#define PGM_P              const char *
+#define pgm_read_byte(p)   (*(const uint8_t *)(p))
+#define pgm_read_word(p)   (*(const uint16_t *)(p))
+#define pgm_read_dword(p)  (*(const uint32_t *)(p))
+#define pgm_read_ptr(p)    (*(void * const *)(p))
+#define strlen_P   strlen
+#define strcmp_P   strcmp
+#define strncmp_P  strncmp
+#define strcpy_P   strcpy
+#define memcpy_P   memcpy
+#define sprintf_P  sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+class __FlashStringHelper;
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define F(s)     FPSTR(PSTR(s))
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+/* Virtual clock, see hostShim.h */
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+/* One core, tasks switch only where they block: nothing to mask */
+#define noInterrupts()
+#define interrupts()
+
+/* GPIO: levels are kept per pin and reported to hostOnPinWrite() */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+/* NTP: time() follows the virtual clock once configTime() was called */
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1,
+                const char *server2 = nullptr, const char *server3 = nullptr);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+#include "WString.h"
+#include "Print.h"
+#include "IPAddress.h"
+
+#endif /* !HOST_ARDUINO_H */
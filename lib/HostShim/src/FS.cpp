@@ -0,0 +1,284 @@
+#include "FS.h"
+#include "LittleFS.h"
+#include "hostShim.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* size of the littlefs partition of the default 4 MB layout */
+#define HOST_FS_SIZE (1441792)
+
+typedef std::shared_ptr<std::vector<uint8_t>> hostData_t;
+
+static std::map<std::string, hostData_t> files;
+static std::set<std::string>             dirs = { "/" };
+
+fs::LittleFSFS LittleFS;
+
+void hostFilesClear(void)
+{
+  files.clear();
+  dirs = { "/" };
+}
+
+namespace fs {
+
+struct FileImpl {
+  std::string              path;
+  hostData_t               data;      /* nullptr for a directory */
+  size_t                   pos;
+  bool                     writable;
+  bool                     append;
+  std::vector<std::string> entries;   /* directory listing */
+  size_t                   next;
+  bool                     open;
+};
+
+/* "/a/b/" -> "/a/b" */
+static std::string normalize(const char *path)
+{
+  std::string p = path ? path : "";
+
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  while (p.size() > 1 && p.back() == '/') p.pop_back();
+  return p;
+}
+
+static std::string parentOf(const std::string &path)
+{
+  size_t slash = path.rfind('/');
+  return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+/* full paths of the direct children of a directory, sorted */
+static std::vector<std::string> listDir(const std::string &dir)
+{
+  std::vector<std::string> out;
+  std::string prefix = dir == "/" ? "/" : dir + "/";
+
+  for (const auto &f : files)
+  {
+    if (f.first.compare(0, prefix.size(), prefix) == 0 &&
+        f.first.find('/', prefix.size()) == std::string::npos) out.push_back(f.first);
+  }
+  for (const auto &d : dirs)
+  {
+    if (d != dir && d.compare(0, prefix.size(), prefix) == 0 &&
+        d.find('/', prefix.size()) == std::string::npos) out.push_back(d);
+  }
+  return out;
+}
+
+File FS::open(const char *path, const char *mode, const bool create)
+{
+  std::string p = normalize(path);
+  FileImplPtr f;
+
+  if (dirs.count(p))
+  {
+    f = std::make_shared<FileImpl>();
+    f->path    = p;
+    f->entries = listDir(p);
+    f->open    = true;
+    return File(f);
+  }
+
+  if (mode[0] == 'r' && mode[1] != '+' && files.count(p) == 0) return File();
+  if (files.count(p) == 0 || mode[0] == 'w')
+  {
+    if (!dirs.count(parentOf(p)) && !create) return File();
+    if (create)
+    {
+      for (std::string d = parentOf(p); d != "/"; d = parentOf(d)) dirs.insert(d);
+    }
+    if (files.count(p) == 0) files[p] = std::make_shared<std::vector<uint8_t>>();
+    if (mode[0] == 'w') files[p]->clear();
+  }
+
+  f = std::make_shared<FileImpl>();
+  f->path     = p;
+  f->data     = files[p];
+  f->writable = mode[0] != 'r' || mode[1] == '+';
+  f->append   = mode[0] == 'a';
+  f->pos      = f->append ? f->data->size() : 0;
+  f->open     = true;
+  return File(f);
+}
+
+bool FS::exists(const char *path)
+{
+  std::string p = normalize(path);
+  return files.count(p) > 0 || dirs.count(p) > 0;
+}
+
+bool FS::remove(const char *path)
+{
+  return files.erase(normalize(path)) > 0;
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo)
+{
+  std::string from = normalize(pathFrom), to = normalize(pathTo);
+
+  if (files.count(from) == 0 || !dirs.count(parentOf(to))) return false;
+  files[to] = files[from];
+  files.erase(from);
+  return true;
+}
+
+bool FS::mkdir(const char *path)
+{
+  std::string p = normalize(path);
+
+  if (files.count(p) || !dirs.count(parentOf(p))) return false;
+  dirs.insert(p);
+  return true;
+}
+
+bool FS::rmdir(const char *path)
+{
+  std::string p = normalize(path);
+
+  if (p == "/" || !listDir(p).empty()) return false;
+  return dirs.erase(p) > 0;
+}
+
+size_t File::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+  if (!*this || !impl->data || !impl->writable) return 0;
+  if (impl->append) impl->pos = impl->data->size();
+  if (impl->pos + size > impl->data->size()) impl->data->resize(impl->pos + size);
+  memcpy(impl->data->data() + impl->pos, buf, size);
+  impl->pos += size;
+  return size;
+}
+
+int File::available()
+{
+  if (!*this || !impl->data) return 0;
+  return impl->data->size() - impl->pos;
+}
+
+int File::read()
+{
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek()
+{
+  if (available() <= 0) return -1;
+  return (*impl->data)[impl->pos];
+}
+
+size_t File::read(uint8_t *buf, size_t size)
+{
+  size_t n = available();
+
+  if (n > size) n = size;
+  if (n > 0) memcpy(buf, impl->data->data() + impl->pos, n);
+  if (n > 0) impl->pos += n;
+  return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+  long base;
+
+  if (!*this || !impl->data) return false;
+  base = mode == SeekSet ? 0 : mode == SeekCur ? (long)impl->pos : (long)impl->data->size();
+  if (base + (long)pos > (long)impl->data->size()) return false;
+  impl->pos = base + pos;
+  return true;
+}
+
+size_t File::position() const
+{
+  return *this && impl->data ? impl->pos : 0;
+}
+
+size_t File::size() const
+{
+  return *this && impl->data ? impl->data->size() : 0;
+}
+
+void File::close()
+{
+  if (impl) impl->open = false;
+  impl.reset();
+}
+
+File::operator bool() const
+{
+  return impl && impl->open;
+}
+
+const char *File::path() const
+{
+  return impl ? impl->path.c_str() : nullptr;
+}
+
+/* the base name, as the 2.x core returns it */
+const char *File::name() const
+{
+  if (!impl) return nullptr;
+  return impl->path.c_str() + impl->path.rfind('/') + 1;
+}
+
+bool File::isDirectory(void)
+{
+  return *this && !impl->data;
+}
+
+File File::openNextFile(const char *mode)
+{
+  FS fs;
+
+  if (!isDirectory()) return File();
+  while (impl->next < impl->entries.size())
+  {
+    const std::string &p = impl->entries[impl->next++];
+    if (files.count(p) || dirs.count(p)) return fs.open(p.c_str(), mode);
+  }
+  return File();
+}
+
+void File::rewindDirectory(void)
+{
+  if (!isDirectory()) return;
+  impl->entries = listDir(impl->path);
+  impl->next    = 0;
+}
+
+bool LittleFSFS::begin(bool /* formatOnFail */, const char * /* basePath */,
+                       uint8_t /* maxOpenFiles */, const char * /* partitionLabel */)
+{
+  return true;
+}
+
+bool LittleFSFS::format()
+{
+  hostFilesClear();
+  return true;
+}
+
+size_t LittleFSFS::totalBytes()
+{
+  return HOST_FS_SIZE;
+}
+
+size_t LittleFSFS::usedBytes()
+{
+  size_t used = 0;
+
+  for (const auto &f : files) used += f.second->size();
+  return used;
+}
+
+} /* namespace fs */
@@ -0,0 +1,73 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <memory>
+#include "Arduino.h"
+
+/* The ESP32 core's fs::FS and fs::File over an in-memory tree, enough of
+ * the API for the fermentation log. Files survive a firmware "reboot"
+ * but not hostFilesClear().
+ */
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FileImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+class File : public Stream {
+public:
+  File(FileImplPtr p = FileImplPtr()) : impl(p) {}
+
+  size_t      write(uint8_t c) override;
+  size_t      write(const uint8_t *buf, size_t size) override;
+  int         available() override;
+  int         read() override;
+  int         peek() override;
+  void        flush() override {}
+  size_t      read(uint8_t *buf, size_t size);
+  size_t      readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+  bool        seek(uint32_t pos, SeekMode mode);
+  bool        seek(uint32_t pos) { return seek(pos, SeekSet); }
+  size_t      position() const;
+  size_t      size() const;
+  void        close();
+  operator bool() const;
+  const char *path() const;
+  const char *name() const;
+  bool        isDirectory(void);
+  File        openNextFile(const char *mode = "r");
+  void        rewindDirectory(void);
+  using Print::write;
+
+private:
+  FileImplPtr impl;
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = "r", const bool create = false);
+  File open(const String &path, const char *mode = "r", const bool create = false)
+  {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *pathFrom, const char *pathTo);
+  bool mkdir(const char *path);
+  bool mkdir(const String &path) { return mkdir(path.c_str()); }
+  bool rmdir(const char *path);
+};
+
+} /* namespace fs */
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif /* !HOST_FS_H */
@@ -0,0 +1,22 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+  bool   begin(bool formatOnFail = false, const char *basePath = "/littlefs",
+               uint8_t maxOpenFiles = 10, const char *partitionLabel = "spiffs");
+  bool   format();
+  size_t totalBytes();
+  size_t usedBytes();
+  void   end() {}
+};
+
+} /* namespace fs */
+
+extern fs::LittleFSFS LittleFS;
+
+#endif /* !HOST_LITTLEFS_H */
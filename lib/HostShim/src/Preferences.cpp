@@ -0,0 +1,102 @@
+#include "Preferences.h"
+#include "hostShim.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/* NVS keys are at most 15 characters, like namespaces */
+#define HOST_NVS_KEY (15)
+
+typedef std::map<std::string, std::vector<uint8_t>> hostNamespace_t;
+
+static std::map<std::string, hostNamespace_t> nvs;
+
+void hostPreferencesClear(void)
+{
+  nvs.clear();
+}
+
+bool Preferences::begin(const char *ns, bool ro, const char * /* partition_label */)
+{
+  if (started || ns == nullptr || strlen(ns) > HOST_NVS_KEY) return false;
+  strlcpy(name, ns, sizeof(name));
+  readOnly = ro;
+  started  = true;
+  return true;
+}
+
+void Preferences::end()
+{
+  started = false;
+}
+
+bool Preferences::clear()
+{
+  if (!started || readOnly) return false;
+  nvs[name].clear();
+  return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+  if (!started || readOnly) return false;
+  return nvs[name].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+  return started && nvs[name].count(key) > 0;
+}
+
+size_t Preferences::putValue(const char *key, const void *value, size_t len)
+{
+  if (!started || readOnly || key == nullptr || strlen(key) > HOST_NVS_KEY) return 0;
+  nvs[name][key].assign((const uint8_t *)value, (const uint8_t *)value + len);
+  return len;
+}
+
+bool Preferences::getRaw(const char *key, void *value, size_t len)
+{
+  hostNamespace_t::iterator it;
+
+  if (!started) return false;
+  it = nvs[name].find(key);
+  if (it == nvs[name].end() || it->second.size() != len) return false;
+  memcpy(value, it->second.data(), len);
+  return true;
+}
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+  return putValue(key, value, strlen(value) + 1);
+}
+
+String Preferences::getString(const char *key, const String defaultValue)
+{
+  hostNamespace_t::iterator it;
+
+  if (!started) return defaultValue;
+  it = nvs[name].find(key);
+  if (it == nvs[name].end() || it->second.empty() || it->second.back() != '\0') return defaultValue;
+  return String((const char *)it->second.data());
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+  hostNamespace_t::iterator it;
+
+  if (!started) return 0;
+  it = nvs[name].find(key);
+  return it == nvs[name].end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen)
+{
+  hostNamespace_t::iterator it;
+
+  if (!started) return 0;
+  it = nvs[name].find(key);
+  if (it == nvs[name].end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
@@ -0,0 +1,127 @@
+#include "Arduino.h"
+#include "hostShim.h"
+#include <stdarg.h>
+
+HardwareSerial Serial;
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size--)
+  {
+    if (write(*buffer++) == 0) break;
+    n++;
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+  return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(long value, int base)
+{
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(long long value, int base)
+{
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits)
+{
+  return print(String(value, (unsigned int)digits));
+}
+
+size_t Print::printf(const char *format, ...)
+{
+  char    small[128];
+  char   *buf = small;
+  va_list args;
+  int     len;
+  size_t  n;
+
+  va_start(args, format);
+  len = vsnprintf(small, sizeof(small), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if ((size_t)len >= sizeof(small))
+  {
+    buf = (char *)malloc(len + 1);
+    if (buf == nullptr) return 0;
+    va_start(args, format);
+    vsnprintf(buf, len + 1, format, args);
+    va_end(args);
+  }
+  n = write((const uint8_t *)buf, len);
+  if (buf != small) free(buf);
+  return n;
+}
+
+int Stream::timedRead()
+{
+  unsigned long started = millis();
+  int c;
+
+  do
+  {
+    c = read();
+    if (c >= 0) return c;
+    delay(1);
+  } while (millis() - started < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t n = 0;
+  int c;
+
+  while (n < length && (c = timedRead()) >= 0)
+  {
+    buffer[n++] = (char)c;
+  }
+  return n;
+}
+
+String Stream::readString()
+{
+  String r;
+  int c;
+
+  while ((c = timedRead()) >= 0) r += (char)c;
+  return r;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+  String r;
+  int c;
+
+  while ((c = timedRead()) >= 0 && c != terminator) r += (char)c;
+  return r;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (hostSerialEchoing()) fwrite(buffer, 1, size, stdout);
+  return size;
+}
@@ -0,0 +1,86 @@
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+class Print;
+
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *str);
+  size_t print(const String &str) { return write(str.c_str(), str.length()); }
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC_BASE) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC_BASE) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC_BASE) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC_BASE);
+  size_t print(unsigned long value, int base = DEC_BASE);
+  size_t print(long long value, int base = DEC_BASE);
+  size_t print(unsigned long long value, int base = DEC_BASE);
+  size_t print(double value, int digits = 2);
+  size_t print(const Printable &p) { return p.printTo(*this); }
+
+  template <typename T>
+  size_t println(const T &value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+  size_t println(void) { return write("\r\n"); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  enum { DEC_BASE = 10 };
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() const { return _timeout; }
+  virtual size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  unsigned long _timeout = 1000;
+  int timedRead();
+};
+
+/* Serial goes to stdout, see hostSerialEcho() */
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long /* baud */) {}
+  void end() {}
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* !HOST_PRINT_H */
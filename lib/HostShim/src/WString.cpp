@@ -0,0 +1,177 @@
+#include "Arduino.h"
+
+static std::string toBase(unsigned long long value, unsigned char base, bool negative)
+{
+  char buf[72];
+  char *p = buf + sizeof(buf) - 1;
+
+  if (base < 2 || base > 36) base = 10;
+  *p = '\0';
+  do
+  {
+    int d = value % base;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10;
+    value /= base;
+  } while (value);
+  if (negative) *--p = '-';
+  return std::string(p);
+}
+
+static std::string signedBase(long long value, unsigned char base)
+{
+  /* like the core, only base 10 shows a sign */
+  if (value < 0 && base == 10) return toBase(-(unsigned long long)value, base, true);
+  return toBase((unsigned long long)value, base, false);
+}
+
+String::String(unsigned char value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(int value, unsigned char base) : s(base == 10 ? signedBase(value, base) : toBase((unsigned int)value, base, false)) {}
+String::String(unsigned int value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(long value, unsigned char base) : s(base == 10 ? signedBase(value, base) : toBase((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(long long value, unsigned char base) : s(signedBase(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : s(toBase(value, base, false)) {}
+
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces)
+{
+  char buf[64];
+
+  if (isnan(value)) s = "nan";
+  else if (isinf(value)) s = value > 0 ? "inf" : "-inf";
+  else
+  {
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    s = buf;
+  }
+}
+
+bool String::equalsIgnoreCase(const String &str) const
+{
+  if (s.size() != str.s.size()) return false;
+  for (size_t i = 0; i < s.size(); i++)
+  {
+    if (tolower((unsigned char)s[i]) != tolower((unsigned char)str.s[i])) return false;
+  }
+  return true;
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const
+{
+  if (offset > s.size()) return false;
+  return s.compare(offset, prefix.s.size(), prefix.s) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+  if (suffix.s.size() > s.size()) return false;
+  return s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const
+{
+  size_t n;
+
+  if (bufsize == 0 || buf == nullptr) return;
+  if (index >= s.size())
+  {
+    buf[0] = '\0';
+    return;
+  }
+  n = s.size() - index;
+  if (n > bufsize - 1) n = bufsize - 1;
+  memcpy(buf, s.data() + index, n);
+  buf[n] = '\0';
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+  size_t p = s.find(ch, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::indexOf(const char *str, unsigned int fromIndex) const
+{
+  size_t p = s.find(str, fromIndex);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::lastIndexOf(char ch) const
+{
+  size_t p = s.rfind(ch);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::lastIndexOf(const String &str) const
+{
+  size_t p = s.rfind(str.s);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+  if (beginIndex > endIndex)
+  {
+    unsigned int t = beginIndex;
+    beginIndex = endIndex;
+    endIndex = t;
+  }
+  if (beginIndex >= s.size()) return String();
+  if (endIndex > s.size()) endIndex = s.size();
+  return String(s.data() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace)
+{
+  for (auto &c : s)
+  {
+    if (c == find) c = replace;
+  }
+}
+
+void String::replace(const String &find, const String &replace)
+{
+  size_t p = 0;
+
+  if (find.s.empty()) return;
+  while ((p = s.find(find.s, p)) != std::string::npos)
+  {
+    s.replace(p, find.s.size(), replace.s);
+    p += replace.s.size();
+  }
+}
+
+void String::toLowerCase()
+{
+  for (auto &c : s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase()
+{
+  for (auto &c : s) c = toupper((unsigned char)c);
+}
+
+void String::trim()
+{
+  size_t b = 0, e = s.size();
+
+  while (b < e && isspace((unsigned char)s[b])) b++;
+  while (e > b && isspace((unsigned char)s[e - 1])) e--;
+  s = s.substr(b, e - b);
+}
+
+long String::toInt() const
+{
+  return atol(s.c_str());
+}
+
+float String::toFloat() const
+{
+  return atof(s.c_str());
+}
+
+double String::toDouble() const
+{
+  return atof(s.c_str());
+}
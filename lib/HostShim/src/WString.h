@@ -0,0 +1,117 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class __FlashStringHelper;
+
+/* Arduino String on top of std::string, same API as the ESP32 core for
+ * what the firmware and its libraries call
+ */
+class String {
+public:
+  String() {}
+  String(const char *cstr) : s(cstr ? cstr : "") {}
+  String(const char *cstr, unsigned int length) : s(cstr, length) {}
+  String(const String &str) = default;
+  String(String &&str) = default;
+  String(const __FlashStringHelper *str) : s(reinterpret_cast<const char *>(str)) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(long long value, unsigned char base = 10);
+  explicit String(unsigned long long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimalPlaces = 2);
+  explicit String(double value, unsigned int decimalPlaces = 2);
+
+  String &operator=(const String &rhs) = default;
+  String &operator=(String &&rhs) = default;
+  String &operator=(const char *cstr) { s = cstr ? cstr : ""; return *this; }
+  String &operator=(const __FlashStringHelper *str) { return *this = reinterpret_cast<const char *>(str); }
+
+  bool reserve(unsigned int size) { s.reserve(size); return true; }
+  unsigned int length() const { return s.size(); }
+  bool isEmpty() const { return s.empty(); }
+  const char *c_str() const { return s.c_str(); }
+  char *begin() { return &s[0]; }
+  char *end() { return &s[0] + s.size(); }
+
+  bool concat(const String &str) { s += str.s; return true; }
+  bool concat(const char *cstr) { if (!cstr) return false; s += cstr; return true; }
+  bool concat(const char *cstr, unsigned int length) { if (!cstr) return false; s.append(cstr, length); return true; }
+  bool concat(const __FlashStringHelper *str) { return concat(reinterpret_cast<const char *>(str)); }
+  bool concat(char c) { s += c; return true; }
+  bool concat(unsigned char num) { return concat(String(num)); }
+  bool concat(int num) { return concat(String(num)); }
+  bool concat(unsigned int num) { return concat(String(num)); }
+  bool concat(long num) { return concat(String(num)); }
+  bool concat(unsigned long num) { return concat(String(num)); }
+  bool concat(long long num) { return concat(String(num)); }
+  bool concat(unsigned long long num) { return concat(String(num)); }
+  bool concat(float num) { return concat(String(num)); }
+  bool concat(double num) { return concat(String(num)); }
+
+  template <typename T>
+  String &operator+=(const T &rhs) { concat(rhs); return *this; }
+
+  int compareTo(const String &str) const { return s.compare(str.s); }
+  bool equals(const String &str) const { return s == str.s; }
+  bool equals(const char *cstr) const { return s == (cstr ? cstr : ""); }
+  bool equalsIgnoreCase(const String &str) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool operator<(const String &rhs) const { return s < rhs.s; }
+  bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  bool startsWith(const String &prefix, unsigned int offset) const;
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+  void setCharAt(unsigned int index, char c) { if (index < s.size()) s[index] = c; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return s[index]; }
+  void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+  void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const
+  {
+    getBytes(reinterpret_cast<unsigned char *>(buf), bufsize, index);
+  }
+
+  int indexOf(char ch, unsigned int fromIndex = 0) const;
+  int indexOf(const char *str, unsigned int fromIndex = 0) const;
+  int indexOf(const String &str, unsigned int fromIndex = 0) const { return indexOf(str.c_str(), fromIndex); }
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(const String &str) const;
+  String substring(unsigned int beginIndex) const { return substring(beginIndex, s.size()); }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const;
+  float toFloat() const;
+  double toDouble() const;
+
+private:
+  std::string s;
+};
+
+/* "a" + String(...) + 1 + ... */
+template <typename T>
+inline String operator+(const String &lhs, const T &rhs) { String r(lhs); r.concat(rhs); return r; }
+inline String operator+(const char *lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+inline String operator+(char lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+inline bool operator==(const char *lhs, const String &rhs) { return rhs == lhs; }
+inline bool operator!=(const char *lhs, const String &rhs) { return rhs != lhs; }
+
+#endif /* !HOST_WSTRING_H */
@@ -0,0 +1,28 @@
+#include "WiFi.h"
+#include "hostShim.h"
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::begin(const char * /* ssid */, const char * /* passphrase */)
+{
+  started   = true;
+  startedAt = millis();
+  return status();
+}
+
+wl_status_t WiFiClass::status()
+{
+  if (!started) return WL_DISCONNECTED;
+  return millis() - startedAt >= HOST_WIFI_DELAY ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool /* wifioff */)
+{
+  started = false;
+  return true;
+}
+
+IPAddress WiFiClass::localIP()
+{
+  return status() == WL_CONNECTED ? IPAddress(192, 168, 4, 2) : IPAddress();
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+typedef enum {
+  WL_IDLE_STATUS     = 0,
+  WL_NO_SSID_AVAIL   = 1,
+  WL_SCAN_COMPLETED  = 2,
+  WL_CONNECTED       = 3,
+  WL_CONNECT_FAILED  = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED    = 6
+} wl_status_t;
+
+/* Associates HOST_WIFI_DELAY ms after begin(), see hostShim.h */
+class WiFiClass {
+public:
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+  wl_status_t status();
+  bool        disconnect(bool wifioff = false);
+  bool        isConnected() { return status() == WL_CONNECTED; }
+  IPAddress   localIP();
+  int8_t      RSSI() { return -60; }
+
+private:
+  bool          started = false;
+  unsigned long startedAt = 0;
+};
+
+extern WiFiClass WiFi;
+
+#endif /* !HOST_WIFI_H */
@@ -0,0 +1,305 @@
+#include "WiFiClientSecure.h"
+#include "WiFi.h"
+#include "hostShim.h"
+#include <ArduinoJson.h>
+#include <deque>
+
+/* bytes of answer a client holds before its buffer has to grow, like the
+ * receive buffer of a TLS session: a batch of updates fits */
+#define ANSWER_BUFFER (8192)
+
+/* Telegram Bot API stand-in shared by every client */
+typedef struct {
+  long        updateId;
+  std::string chatId;
+  std::string from;
+  std::string text;
+  time_t      date;
+} hostUpdate_t;
+
+static std::deque<hostUpdate_t> updates;
+static long            nextUpdateId  = 1;
+static long            nextMessageId = 1;
+static bool            online        = true;
+static uint32_t        requests      = 0;
+static hostReplyHook_t replyHook     = nullptr;
+static void           *replyHookArg  = nullptr;
+
+void hostTelegramMessage(const char *chat_id, const char *from, const char *text)
+{
+  updates.push_back({ nextUpdateId++, chat_id, from, text, time(nullptr) });
+}
+
+void hostOnTelegramReply(hostReplyHook_t hook, void *arg)
+{
+  replyHook    = hook;
+  replyHookArg = arg;
+}
+
+void hostTelegramOnline(bool on)
+{
+  online = on;
+}
+
+uint32_t hostTelegramRequests(void)
+{
+  return requests;
+}
+
+static std::string urlDecode(const std::string &in)
+{
+  std::string out;
+
+  for (size_t i = 0; i < in.size(); i++)
+  {
+    if (in[i] == '+') out += ' ';
+    else if (in[i] == '%' && i + 2 < in.size())
+    {
+      out += (char)strtol(in.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    }
+    else out += in[i];
+  }
+  return out;
+}
+
+/* value of name in "a=1&b=2", "" if absent */
+static std::string queryParam(const std::string &query, const char *name)
+{
+  std::string key = std::string(name) + "=";
+  size_t p = 0;
+
+  while (p < query.size())
+  {
+    size_t end = query.find('&', p);
+    if (end == std::string::npos) end = query.size();
+    if (query.compare(p, key.size(), key) == 0)
+    {
+      return urlDecode(query.substr(p + key.size(), end - p - key.size()));
+    }
+    p = end + 1;
+  }
+  return "";
+}
+
+static void deliverReply(const std::string &chatId, const std::string &text)
+{
+  if (replyHook != nullptr) replyHook(chatId.c_str(), text.c_str(), replyHookArg);
+}
+
+int WiFiClientSecure::connect(IPAddress /* ip */, uint16_t port)
+{
+  return connect("", port);
+}
+
+int WiFiClientSecure::connect(const char *host, uint16_t /* port */)
+{
+  stop();
+  if (!online || WiFi.status() != WL_CONNECTED || strcmp(host, "api.telegram.org") != 0) return 0;
+  open = true;
+  return 1;
+}
+
+size_t WiFiClientSecure::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t WiFiClientSecure::write(const uint8_t *buf, size_t size)
+{
+  if (!open) return 0;
+  request.append((const char *)buf, size);
+  handleRequests();
+  return size;
+}
+
+int WiFiClientSecure::available()
+{
+  if (!open) return 0;
+  if (polling && (!updates.empty() || (int32_t)(millis() - pollDeadline) >= 0))
+  {
+    answerUpdates();
+  }
+  return response.size() - readPos;
+}
+
+int WiFiClientSecure::read()
+{
+  if (available() <= 0) return -1;
+  return (uint8_t)response[readPos++];
+}
+
+int WiFiClientSecure::read(uint8_t *buf, size_t size)
+{
+  int n = available();
+
+  if (n <= 0) return -1;
+  if ((size_t)n > size) n = size;
+  memcpy(buf, response.data() + readPos, n);
+  readPos += n;
+  return n;
+}
+
+int WiFiClientSecure::peek()
+{
+  if (available() <= 0) return -1;
+  return (uint8_t)response[readPos];
+}
+
+void WiFiClientSecure::stop()
+{
+  open       = false;
+  closeAfter = false;
+  polling    = false;
+  request.clear();
+  response.clear();
+  readPos = 0;
+}
+
+uint8_t WiFiClientSecure::connected()
+{
+  if (open && closeAfter && readPos >= response.size()) stop();
+  return open;
+}
+
+/* answer every complete request written so far */
+void WiFiClientSecure::handleRequests()
+{
+  size_t headEnd, lineEnd, sp1, sp2, p;
+  size_t length;
+  bool   keepAlive;
+  std::string head, lower;
+
+  while ((headEnd = request.find("\r\n\r\n")) != std::string::npos)
+  {
+    head  = request.substr(0, headEnd);
+    lower = head;
+    for (auto &c : lower) c = tolower((unsigned char)c);
+
+    length = 0;
+    p = lower.find("\r\ncontent-length:");
+    if (p != std::string::npos) length = strtoul(lower.c_str() + p + 17, nullptr, 10);
+    if (request.size() < headEnd + 4 + length) return;
+    keepAlive = lower.find("\r\nconnection: close") == std::string::npos;
+
+    lineEnd = head.find("\r\n");
+    sp1 = head.find(' ');
+    sp2 = head.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos || sp2 > lineEnd)
+    {
+      request.clear();
+      answer("{\"ok\":false,\"error_code\":400,\"description\":\"Bad Request\"}");
+      return;
+    }
+    handle(head.substr(0, sp1), head.substr(sp1 + 1, sp2 - sp1 - 1),
+           request.substr(headEnd + 4, length), keepAlive);
+    request.erase(0, headEnd + 4 + length);
+  }
+}
+
+void WiFiClientSecure::handle(const std::string &method, const std::string &target,
+                              const std::string &body, bool keepAlive)
+{
+  size_t slash = target.find('/', 1);
+  size_t quest = target.find('?');
+  std::string name  = target.substr(slash + 1, quest == std::string::npos ? std::string::npos : quest - slash - 1);
+  std::string query = quest == std::string::npos ? "" : target.substr(quest + 1);
+  std::string chatId, text, out;
+  JsonDocument doc;
+
+  requests++;
+  closeAfter = !keepAlive;
+
+  if (slash == std::string::npos || target.compare(0, 4, "/bot") != 0)
+  {
+    answer("{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+    return;
+  }
+  if (name == "getUpdates")
+  {
+    pollOffset   = atol(queryParam(query, "offset").c_str());
+    pollLimit    = atoi(queryParam(query, "limit").c_str());
+    pollDeadline = millis() + atol(queryParam(query, "timeout").c_str()) * 1000;
+    polling      = true;
+    while (!updates.empty() && updates.front().updateId < pollOffset) updates.pop_front();
+    if (!updates.empty() || queryParam(query, "timeout").empty()) answerUpdates();
+    return;
+  }
+  if (name == "sendMessage" || name == "editMessageText")
+  {
+    if (method == "POST")
+    {
+      deserializeJson(doc, body);
+      chatId = doc["chat_id"].is<const char *>() ? doc["chat_id"].as<const char *>()
+                                                 : std::to_string(doc["chat_id"].as<long long>());
+      text = doc["text"] | "";
+    }
+    else
+    {
+      chatId = queryParam(query, "chat_id");
+      text   = queryParam(query, "text");
+    }
+    deliverReply(chatId, text);
+    doc.clear();
+    doc["ok"] = true;
+    doc["result"]["message_id"] = nextMessageId++;
+    doc["result"]["chat"]["id"] = chatId;
+    doc["result"]["text"] = text;
+    serializeJson(doc, out);
+    answer(out);
+    return;
+  }
+  if (name == "getMe")
+  {
+    answer("{\"ok\":true,\"result\":{\"id\":1,\"is_bot\":true,\"first_name\":\"host\",\"username\":\"host_bot\"}}");
+    return;
+  }
+  answer("{\"ok\":true,\"result\":true}");
+}
+
+void WiFiClientSecure::answerUpdates()
+{
+  JsonDocument doc;
+  JsonArray    result;
+  std::string  out;
+  int          n = 0;
+
+  polling = false;
+  doc["ok"] = true;
+  result = doc["result"].to<JsonArray>();
+  for (const hostUpdate_t &u : updates)
+  {
+    if (u.updateId < pollOffset) continue;
+    if (pollLimit > 0 && n >= pollLimit) break;
+    JsonObject update  = result.add<JsonObject>();
+    JsonObject message = update["message"].to<JsonObject>();
+    update["update_id"]             = u.updateId;
+    message["message_id"]           = nextMessageId++;
+    message["from"]["id"]           = u.chatId;
+    message["from"]["first_name"]   = u.from;
+    message["chat"]["id"]           = u.chatId;
+    message["chat"]["type"]         = "private";
+    message["date"]                 = (long)u.date;
+    message["text"]                 = u.text;
+    n++;
+  }
+  /* one allocation whatever the batch: the client's own are what tests count */
+  out.reserve(measureJson(doc));
+  serializeJson(doc, out);
+  answer(out);
+}
+
+void WiFiClientSecure::answer(const std::string &body)
+{
+  char head[160];
+
+  snprintf(head, sizeof(head),
+           "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+           "Content-Length: %u\r\nConnection: %s\r\n\r\n",
+           (unsigned)body.size(), closeAfter ? "close" : "keep-alive");
+  response.erase(0, readPos);
+  readPos = 0;
+  if (response.capacity() < ANSWER_BUFFER) response.reserve(ANSWER_BUFFER);
+  response += head;
+  response += body;
+}
@@ -0,0 +1,49 @@
+#ifndef HOST_WIFI_CLIENT_SECURE_H
+#define HOST_WIFI_CLIENT_SECURE_H
+
+#include <string>
+#include "Client.h"
+
+/* A TLS client whose only reachable server is the Telegram Bot API
+ * stand-in in WiFiClientSecure.cpp. Requests are answered as soon as
+ * they are complete, a getUpdates long poll when an update is queued
+ * with hostTelegramMessage() or when its timeout passes.
+ */
+class WiFiClientSecure : public Client {
+public:
+  int     connect(IPAddress ip, uint16_t port) override;
+  int     connect(const char *host, uint16_t port) override;
+  size_t  write(uint8_t c) override;
+  size_t  write(const uint8_t *buf, size_t size) override;
+  int     available() override;
+  int     read() override;
+  int     read(uint8_t *buf, size_t size) override;
+  int     peek() override;
+  void    flush() override {}
+  void    stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+  using Print::write;
+
+  void setCACert(const char * /* rootCA */) {}
+  void setInsecure() {}
+
+private:
+  bool          open = false;
+  bool          closeAfter = false;  /* the answer said Connection: close */
+  std::string   request;             /* written, not handled yet */
+  std::string   response;            /* answer not read yet */
+  size_t        readPos = 0;
+  bool          polling = false;     /* getUpdates held open */
+  long          pollOffset = 0;
+  int           pollLimit = 0;
+  unsigned long pollDeadline = 0;
+
+  void handleRequests();
+  void handle(const std::string &method, const std::string &target, const std::string &body,
+              bool keepAlive);
+  void answerUpdates();
+  void answer(const std::string &body);
+};
+
+#endif /* !HOST_WIFI_CLIENT_SECURE_H */
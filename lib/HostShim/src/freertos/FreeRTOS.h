@@ -0,0 +1,42 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+/* FreeRTOS as the ESP32 core configures it: 1 ms ticks. The kernel is
+ * emulated by hostScheduler.cpp on a virtual clock.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t     TickType_t;
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE (0)
+#define pdTRUE  (1)
+#define pdFAIL  (pdFALSE)
+#define pdPASS  (pdTRUE)
+
+#define configTICK_RATE_HZ   (1000)
+#define configMAX_PRIORITIES (25)
+#define portMAX_DELAY        ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS   ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define configASSERT(x)      do { if (!(x)) hostAssertFailed(#x, __FILE__, __LINE__); } while (0)
+
+void hostAssertFailed(const char *expr, const char *file, int line);
+
+/* Tasks never run concurrently, critical sections have nothing to do */
+typedef struct {
+  uint32_t owner;
+  uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0, 0 }
+#define portENTER_CRITICAL(mux)     ((void)(mux))
+#define portEXIT_CRITICAL(mux)      ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux))
+#define portYIELD()                 taskYIELD()
+
+#endif /* !HOST_FREERTOS_H */
@@ -0,0 +1,21 @@
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct hostQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void          vQueueDelete(QueueHandle_t queue);
+BaseType_t    xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t    xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t    xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t    xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+BaseType_t    xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t   uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t    xQueueReset(QueueHandle_t queue);
+#define xQueueSend(queue, item, ticks) xQueueSendToBack((queue), (item), (ticks))
+#define xQueueSendFromISR(queue, item, woken) xQueueSendToBack((queue), (item), 0)
+
+#endif /* !HOST_QUEUE_H */
@@ -0,0 +1,24 @@
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "queue.h"
+
+/* Mutexes, counting and binary semaphores. Mutexes have an owner and may
+ * be taken recursively with the *Recursive calls, there is no priority
+ * inheritance.
+ */
+typedef struct hostSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t        xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t        xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+UBaseType_t       uxSemaphoreGetCount(SemaphoreHandle_t sem);
+#define xSemaphoreGiveFromISR(sem, woken) xSemaphoreGive(sem)
+
+#endif /* !HOST_SEMPHR_H */
@@ -0,0 +1,47 @@
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct hostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite
+} eNotifyAction;
+
+#define tskIDLE_PRIORITY (0)
+#define tskNO_AFFINITY   (0x7FFFFFFF)
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth,
+                                   void *parameters, UBaseType_t priority, TaskHandle_t *created,
+                                   BaseType_t coreId);
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
+void       vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment);
+BaseType_t xTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void       taskYIELD(void);
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              uint32_t *previousValue);
+#define xTaskNotify(task, value, action) xTaskGenericNotify((task), (value), (action), NULL)
+#define xTaskNotifyGive(task)            xTaskGenericNotify((task), 0, eIncrement, NULL)
+#define xTaskNotifyFromISR(task, value, action, woken) \
+  xTaskGenericNotify((task), (value), (action), NULL)
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit,
+                           uint32_t *value, TickType_t ticksToWait);
+uint32_t   ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+
+#endif /* !HOST_TASK_H */
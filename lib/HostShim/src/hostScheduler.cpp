@@ -0,0 +1,796 @@
+/* FreeRTOS kernel and Arduino time/GPIO on a virtual clock, see hostShim.h.
+ *
+ * Each task owns a thread and a condition variable. The running task is
+ * `current`; every other thread waits on its condition variable until it
+ * is handed the CPU. All kernel state is guarded by `kernel`, task code
+ * runs without it.
+ */
+#include "Arduino.h"
+#include "hostShim.h"
+#include <unistd.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <string>
+
+#define HOST_FOREVER  (UINT64_MAX)
+#define HOST_YIELD_US (100)    /* Arduino yield() sleeps this long */
+#define HOST_PINS     (64)
+#define HOST_EPOCH    (1767225600)  /* 2026-01-01 00:00:00 UTC */
+
+typedef std::unique_lock<std::mutex> kernelLock_t;
+
+struct hostTask {
+  TaskFunction_t          code;
+  void                   *arg;
+  std::string             name;
+  UBaseType_t             priority;
+  uint32_t                index;       /* creation order */
+  std::condition_variable cv;
+  bool                    ready;
+  bool                    deleted;
+  bool                    timedOut;    /* last block ended by its timeout */
+  uint64_t                wake;        /* us the timeout expires */
+  uint64_t                order;       /* when it became ready */
+  uint32_t                notifyValue;
+  bool                    notifyPending;
+  bool                    notifyWaiting; /* blocked in a notification wait */
+};
+
+struct hostQueue {
+  size_t                            itemSize;
+  size_t                            length;
+  std::deque<std::vector<uint8_t>>  items;
+  std::vector<hostTask *>           receivers;
+  std::vector<hostTask *>           senders;
+};
+
+struct hostSemaphore {
+  bool                    isMutex;
+  UBaseType_t             count;
+  UBaseType_t             maxCount;
+  hostTask               *holder;
+  uint32_t                depth;       /* recursive takes */
+  std::vector<hostTask *> waiters;
+};
+
+static std::mutex               kernel;
+static std::vector<hostTask *>  tasks;
+static hostTask                *current = nullptr;
+static uint64_t                 nowUs = 0;
+static uint64_t                 readySeq = 0;
+
+static uint8_t       pinLevels[HOST_PINS];
+static hostPinHook_t pinHook = nullptr;
+static void         *pinHookArg = nullptr;
+
+static time_t   epoch = HOST_EPOCH;
+static bool     ntpStarted = false;
+static uint64_t ntpAt;
+
+static bool          serialEcho = false;
+static unsigned long randomState = 1;
+
+/** scheduler ********************************************/
+
+static void makeReady(hostTask *t)
+{
+  t->ready = true;
+  t->wake  = HOST_FOREVER;
+  t->order = readySeq++;
+}
+
+/* ready every task whose timeout expired, earliest timeout first */
+static void expireTimeouts(void)
+{
+  while (1)
+  {
+    hostTask *first = nullptr;
+    for (hostTask *t : tasks)
+    {
+      if (t->ready || t->deleted || t->wake > nowUs) continue;
+      if (first == nullptr || t->wake < first->wake) first = t;
+    }
+    if (first == nullptr) return;
+    first->timedOut = true;
+    makeReady(first);
+  }
+}
+
+static hostTask *pickNext(void)
+{
+  hostTask *best;
+  uint64_t  next;
+
+  while (1)
+  {
+    expireTimeouts();
+    best = nullptr;
+    for (hostTask *t : tasks)
+    {
+      if (!t->ready || t->deleted) continue;
+      if (best == nullptr || t->priority > best->priority ||
+          (t->priority == best->priority && t->order < best->order)) best = t;
+    }
+    if (best != nullptr) return best;
+
+    /* everybody sleeps: jump to the first timeout */
+    next = HOST_FOREVER;
+    for (hostTask *t : tasks)
+    {
+      if (!t->deleted && t->wake < next) next = t->wake;
+    }
+    if (next == HOST_FOREVER)
+    {
+      fprintf(stderr, "host: every task is blocked forever\n");
+      hostExit(2);
+    }
+    nowUs = next;
+  }
+}
+
+/* hand the CPU to the next task, return when it comes back to us */
+static void switchAway(kernelLock_t &lk)
+{
+  hostTask *self = current;
+  hostTask *next = pickNext();
+
+  if (next != self)
+  {
+    current = next;
+    next->cv.notify_one();
+    while (current != self) self->cv.wait(lk);
+  }
+  self->ready = false;
+}
+
+/* block the running task until woken or until the deadline, true if woken */
+static bool block(kernelLock_t &lk, uint64_t deadline)
+{
+  hostTask *self = current;
+
+  self->ready    = false;
+  self->timedOut = false;
+  self->wake     = deadline;
+  switchAway(lk);
+  return !self->timedOut;
+}
+
+/* let a task woken by an event run now if it outranks the running one */
+static void preempt(kernelLock_t &lk)
+{
+  for (hostTask *t : tasks)
+  {
+    if (t->ready && !t->deleted && t != current && t->priority > current->priority)
+    {
+      makeReady(current);
+      switchAway(lk);
+      return;
+    }
+  }
+}
+
+static uint64_t deadlineFor(TickType_t ticks)
+{
+  if (ticks == portMAX_DELAY) return HOST_FOREVER;
+  return nowUs + (uint64_t)ticks * 1000 * portTICK_PERIOD_MS;
+}
+
+/* wait in a list until woken or the deadline passes, false on timeout */
+static bool waitIn(kernelLock_t &lk, std::vector<hostTask *> &list, uint64_t deadline)
+{
+  bool woken;
+
+  list.push_back(current);
+  woken = block(lk, deadline);
+  for (size_t i = 0; i < list.size(); i++)
+  {
+    if (list[i] == current)
+    {
+      list.erase(list.begin() + i);
+      break;
+    }
+  }
+  return woken;
+}
+
+/* wake the highest priority waiter, the longest waiting among equals */
+static void wakeOne(std::vector<hostTask *> &list)
+{
+  hostTask *best = nullptr;
+
+  for (hostTask *t : list)
+  {
+    if (t->ready || t->deleted) continue;
+    if (best == nullptr || t->priority > best->priority) best = t;
+  }
+  if (best != nullptr) makeReady(best);
+}
+
+static void taskMain(hostTask *t)
+{
+  kernelLock_t lk(kernel);
+
+  while (current != t) t->cv.wait(lk);
+  t->ready = false;
+  lk.unlock();
+  t->code(t->arg);
+
+  fprintf(stderr, "host: task %s returned\n", t->name.c_str());
+  hostExit(3);
+}
+
+/** harness ********************************************/
+
+void hostBegin(void)
+{
+  kernelLock_t lk(kernel);
+  hostTask *t = new hostTask();
+
+  t->name     = "loopTask";
+  t->priority = 1;
+  t->index    = tasks.size();
+  t->wake     = HOST_FOREVER;
+  tasks.push_back(t);
+  current = t;
+}
+
+void hostRun(uint32_t ms)
+{
+  kernelLock_t lk(kernel);
+  block(lk, nowUs + (uint64_t)ms * 1000);
+}
+
+uint64_t hostMicros(void)
+{
+  return nowUs;
+}
+
+void hostExit(int code)
+{
+  fflush(stdout);
+  fflush(stderr);
+  _exit(code);
+}
+
+void hostAssertFailed(const char *expr, const char *file, int line)
+{
+  fprintf(stderr, "host: assertion %s failed at %s:%d\n", expr, file, line);
+  hostExit(3);
+}
+
+void hostSerialEcho(bool on)
+{
+  serialEcho = on;
+}
+
+bool hostSerialEchoing(void)
+{
+  return serialEcho;
+}
+
+void hostSetEpoch(time_t e)
+{
+  epoch = e;
+}
+
+/** tasks ********************************************/
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t /* stackDepth */,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created)
+{
+  kernelLock_t lk(kernel);
+  hostTask *t = new hostTask();
+
+  t->code     = code;
+  t->arg      = parameters;
+  t->name     = name ? name : "";
+  t->priority = priority < configMAX_PRIORITIES ? priority : configMAX_PRIORITIES - 1;
+  t->index    = tasks.size();
+  tasks.push_back(t);
+  makeReady(t);
+  if (created != nullptr) *created = t;
+  std::thread(taskMain, t).detach();
+  preempt(lk);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth,
+                                   void *parameters, UBaseType_t priority, TaskHandle_t *created,
+                                   BaseType_t /* coreId */)
+{
+  return xTaskCreate(code, name, stackDepth, parameters, priority, created);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  kernelLock_t lk(kernel);
+
+  if (task == nullptr) task = current;
+  task->deleted = true;
+  task->ready   = false;
+  if (task == current)
+  {
+    /* never handed the CPU again, the thread waits until the process ends */
+    switchAway(lk);
+  }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  kernelLock_t lk(kernel);
+
+  if (ticks == 0)
+  {
+    makeReady(current);
+    switchAway(lk);
+    return;
+  }
+  block(lk, deadlineFor(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+  kernelLock_t lk(kernel);
+  uint64_t wake = ((uint64_t)*previousWakeTime + increment) * 1000 * portTICK_PERIOD_MS;
+
+  *previousWakeTime += increment;
+  if (wake <= nowUs) return pdFALSE;
+  block(lk, wake);
+  return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+  xTaskDelayUntil(previousWakeTime, increment);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+  return (TickType_t)(nowUs / (1000 * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+  return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+  return current;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+  return (task ? task : current)->name.c_str();
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+  return (task ? task : current)->priority;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t /* task */)
+{
+  return 0;
+}
+
+void taskYIELD(void)
+{
+  vTaskDelay(0);
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              uint32_t *previousValue)
+{
+  kernelLock_t lk(kernel);
+
+  if (previousValue != nullptr) *previousValue = task->notifyValue;
+  switch (action)
+  {
+    case eSetBits :
+      task->notifyValue |= value;
+      break;
+    case eIncrement :
+      task->notifyValue++;
+      break;
+    case eSetValueWithOverwrite :
+      task->notifyValue = value;
+      break;
+    case eSetValueWithoutOverwrite :
+      if (task->notifyPending) return pdFAIL;
+      task->notifyValue = value;
+      break;
+    default:
+      break;
+  }
+  task->notifyPending = true;
+  if (task->notifyWaiting && !task->ready) makeReady(task);
+  preempt(lk);
+  return pdPASS;
+}
+
+/* wait until a notification is pending or the deadline passes */
+static bool waitNotify(kernelLock_t &lk, TickType_t ticksToWait)
+{
+  uint64_t deadline = deadlineFor(ticksToWait);
+
+  while (!current->notifyPending && ticksToWait != 0)
+  {
+    current->notifyWaiting = true;
+    bool woken = block(lk, deadline);
+    current->notifyWaiting = false;
+    if (!woken) break;
+  }
+  return current->notifyPending;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit,
+                           uint32_t *value, TickType_t ticksToWait)
+{
+  kernelLock_t lk(kernel);
+  hostTask *self = current;
+
+  if (!self->notifyPending) self->notifyValue &= ~clearOnEntry;
+  if (!waitNotify(lk, ticksToWait))
+  {
+    if (value != nullptr) *value = self->notifyValue;
+    return pdFALSE;
+  }
+  if (value != nullptr) *value = self->notifyValue;
+  self->notifyValue  &= ~clearOnExit;
+  self->notifyPending = false;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+  kernelLock_t lk(kernel);
+  hostTask *self = current;
+  uint32_t value;
+
+  if (self->notifyValue == 0) self->notifyPending = false;
+  waitNotify(lk, ticksToWait);
+  value = self->notifyValue;
+  if (value != 0) self->notifyValue = clearOnExit ? 0 : value - 1;
+  self->notifyPending = false;
+  return value;
+}
+
+/** queues ********************************************/
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  hostQueue *q = new hostQueue();
+
+  q->itemSize = itemSize;
+  q->length   = length;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+  delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait,
+                            bool front, bool overwrite)
+{
+  kernelLock_t lk(kernel);
+  uint64_t deadline = deadlineFor(ticksToWait);
+  std::vector<uint8_t> copy((const uint8_t *)item, (const uint8_t *)item + q->itemSize);
+
+  while (q->items.size() >= q->length && !overwrite)
+  {
+    if (ticksToWait == 0 || !waitIn(lk, q->senders, deadline))
+    {
+      if (q->items.size() >= q->length) return pdFALSE;
+    }
+  }
+  if (overwrite && q->items.size() >= q->length) q->items.pop_back();
+  if (front) q->items.push_front(copy);
+  else q->items.push_back(copy);
+  wakeOne(q->receivers);
+  preempt(lk);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+  return queueSend(queue, item, ticksToWait, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+  return queueSend(queue, item, ticksToWait, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+  return queueSend(queue, item, 0, false, true);
+}
+
+static BaseType_t queueReceive(QueueHandle_t q, void *buffer, TickType_t ticksToWait, bool peek)
+{
+  kernelLock_t lk(kernel);
+  uint64_t deadline = deadlineFor(ticksToWait);
+
+  while (q->items.empty())
+  {
+    if (ticksToWait == 0 || !waitIn(lk, q->receivers, deadline))
+    {
+      if (q->items.empty()) return pdFALSE;
+    }
+  }
+  memcpy(buffer, q->items.front().data(), q->itemSize);
+  if (!peek)
+  {
+    q->items.pop_front();
+    wakeOne(q->senders);
+    preempt(lk);
+  }
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait)
+{
+  return queueReceive(queue, buffer, ticksToWait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait)
+{
+  return queueReceive(queue, buffer, ticksToWait, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+  kernelLock_t lk(kernel);
+  return queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+  kernelLock_t lk(kernel);
+  return queue->length - queue->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+  kernelLock_t lk(kernel);
+  queue->items.clear();
+  wakeOne(queue->senders);
+  return pdPASS;
+}
+
+/** semaphores ********************************************/
+
+static SemaphoreHandle_t newSemaphore(bool isMutex, UBaseType_t maxCount, UBaseType_t count)
+{
+  hostSemaphore *s = new hostSemaphore();
+
+  s->isMutex  = isMutex;
+  s->maxCount = maxCount;
+  s->count    = count;
+  s->holder   = nullptr;
+  s->depth    = 0;
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+  return newSemaphore(true, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+  return newSemaphore(true, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+  return newSemaphore(false, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+  return newSemaphore(false, maxCount, initialCount);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+  delete sem;
+}
+
+static BaseType_t semTake(SemaphoreHandle_t s, TickType_t ticksToWait)
+{
+  kernelLock_t lk(kernel);
+  uint64_t deadline = deadlineFor(ticksToWait);
+
+  while (s->count == 0)
+  {
+    if (ticksToWait == 0 || !waitIn(lk, s->waiters, deadline))
+    {
+      if (s->count == 0) return pdFALSE;
+    }
+  }
+  s->count--;
+  if (s->isMutex) s->holder = current;
+  return pdTRUE;
+}
+
+static BaseType_t semGive(SemaphoreHandle_t s)
+{
+  kernelLock_t lk(kernel);
+
+  if (s->isMutex && s->holder != current) return pdFALSE;
+  if (s->count >= s->maxCount) return pdFALSE;
+  s->count++;
+  s->holder = nullptr;
+  wakeOne(s->waiters);
+  preempt(lk);
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+  return semTake(sem, ticksToWait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+  return semGive(sem);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+  {
+    kernelLock_t lk(kernel);
+    if (sem->holder == current)
+    {
+      sem->depth++;
+      return pdTRUE;
+    }
+  }
+  return semTake(sem, ticksToWait);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+  {
+    kernelLock_t lk(kernel);
+    if (sem->holder == current && sem->depth > 0)
+    {
+      sem->depth--;
+      return pdTRUE;
+    }
+  }
+  return semGive(sem);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem)
+{
+  kernelLock_t lk(kernel);
+  return sem->count;
+}
+
+/** Arduino ********************************************/
+
+unsigned long millis(void)
+{
+  return (unsigned long)(uint32_t)(nowUs / 1000);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)(uint32_t)nowUs;
+}
+
+void delay(uint32_t ms)
+{
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+/* a busy wait: the clock moves, nobody else runs */
+void delayMicroseconds(uint32_t us)
+{
+  kernelLock_t lk(kernel);
+  nowUs += us;
+}
+
+/* lets every other ready task run, lower priorities included, so that
+ * loops polling with yield() make progress
+ */
+void yield(void)
+{
+  kernelLock_t lk(kernel);
+  block(lk, nowUs + HOST_YIELD_US);
+}
+
+void pinMode(uint8_t /* pin */, uint8_t /* mode */)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  uint8_t level = val ? HIGH : LOW;
+
+  if (pin >= HOST_PINS || pinLevels[pin] == level) return;
+  pinLevels[pin] = level;
+  if (pinHook != nullptr) pinHook(pin, level, pinHookArg);
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < HOST_PINS ? pinLevels[pin] : LOW;
+}
+
+int hostPinLevel(uint8_t pin)
+{
+  return digitalRead(pin);
+}
+
+void hostSetPinLevel(uint8_t pin, uint8_t level)
+{
+  if (pin < HOST_PINS) pinLevels[pin] = level ? HIGH : LOW;
+}
+
+void hostOnPinWrite(hostPinHook_t hook, void *arg)
+{
+  pinHook    = hook;
+  pinHookArg = arg;
+}
+
+void configTime(long /* gmtOffset_sec */, int /* daylightOffset_sec */, const char * /* server1 */,
+                const char * /* server2 */, const char * /* server3 */)
+{
+  if (ntpStarted) return;
+  ntpStarted = true;
+  ntpAt      = nowUs + (uint64_t)HOST_NTP_DELAY * 1000;
+}
+
+/* replaces the C library's, so the firmware sees the virtual wall clock:
+ * seconds since boot until NTP answered, like the ESP32
+ */
+extern "C" time_t time(time_t *t) noexcept
+{
+  time_t now = nowUs / 1000000;
+
+  if (ntpStarted && nowUs >= ntpAt) now += epoch;
+  if (t != nullptr) *t = now;
+  return now;
+}
+
+long random(long howbig)
+{
+  if (howbig <= 0) return 0;
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (long)((randomState >> 8) % (unsigned long)howbig);
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0) randomState = seed;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+
+  if (size > 0)
+  {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* Harness side of the host shim.
+ *
+ * Every FreeRTOS task runs on its own thread, but only one of them at a
+ * time: a task keeps the CPU until it blocks (delay, vTaskDelay, queue,
+ * semaphore or notification wait, yield) or readies a task of higher
+ * priority, like FreeRTOS on one core without time slicing. Code runs in
+ * zero virtual time; only blocking and delayMicroseconds() move the clock.
+ * When every task is blocked the clock jumps to the earliest timeout, so
+ * an idle firmware covers days of virtual time in milliseconds. Among
+ * ready tasks the highest priority runs first, then the one that became
+ * ready first, which makes every run with the same inputs identical.
+ *
+ * The thread calling hostBegin() becomes the Arduino loop task (priority
+ * 1). It calls setup() itself, then hostRun() to let the other tasks run.
+ */
+
+void     hostBegin(void);
+/* Block the loop task for ms of virtual time while the tasks run */
+void     hostRun(uint32_t ms);
+uint64_t hostMicros(void);
+/* Flush stdout and end the process, tasks blocked on threads included */
+void     hostExit(int code);
+
+/* Echo Serial to stdout, off by default */
+void hostSerialEcho(bool on);
+bool hostSerialEchoing(void);
+
+/* GPIO */
+typedef void (*hostPinHook_t)(uint8_t pin, uint8_t level, void *arg);
+int  hostPinLevel(uint8_t pin);
+void hostSetPinLevel(uint8_t pin, uint8_t level);
+/* Called on every digitalWrite() that changes a level */
+void hostOnPinWrite(hostPinHook_t hook, void *arg);
+
+/* Wall clock reported by time() once configTime() was called, s at the
+ * moment of the call. NTP answers after HOST_NTP_DELAY ms.
+ */
+#define HOST_NTP_DELAY (1500)
+void hostSetEpoch(time_t epoch);
+/* WiFi associates HOST_WIFI_DELAY ms after WiFi.begin() */
+#define HOST_WIFI_DELAY (2000)
+
+/* Preferences and LittleFS live in memory, these wipe them */
+void hostPreferencesClear(void);
+void hostFilesClear(void);
+
+/* Telegram Bot API stand-in reached by every WiFiClientSecure.
+ * Updates are queued for getUpdates, sendMessage calls reach the hook.
+ */
+typedef void (*hostReplyHook_t)(const char *chat_id, const char *text, void *arg);
+void     hostTelegramMessage(const char *chat_id, const char *from, const char *text);
+void     hostOnTelegramReply(hostReplyHook_t hook, void *arg);
+/* Offline: connections are refused */
+void     hostTelegramOnline(bool online);
+uint32_t hostTelegramRequests(void);
+
+#endif /* !HOST_SHIM_H */
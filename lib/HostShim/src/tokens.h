@@ -0,0 +1,16 @@
+#ifndef HOST_TOKENS_H
+#define HOST_TOKENS_H
+
+/* Stand-in credentials for host builds, a real include/tokens.h wins.
+ * Two chambers, src/host/hostMain.cpp puts their probes on the
+ * simulated bus.
+ */
+#define WIFI_SSID         "host"
+#define WIFI_PASSWORD     "host"
+#define BOT_TOKEN         "000000000:host"
+#define DS18B20_CHAMBER   { 0x28, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x29 }
+#define DS18B20_LIQUID    { 0x28, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70 }
+#define DS18B20_CHAMBER_2 { 0x28, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47 }
+#define DS18B20_LIQUID_2  { 0x28, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC2 }
+
+#endif /* !HOST_TOKENS_H */
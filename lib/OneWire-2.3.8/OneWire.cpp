@@ -149,9 +149,13 @@ sample code bearing this copyright.
 #include "util/OneWire_direct_gpio.h"
 
 #ifdef ARDUINO_ARCH_ESP32
-// due to the dual core esp32, a critical section works better than disabling interrupts
-#  define noInterrupts() {portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;portENTER_CRITICAL(&mux)
-#  define interrupts() portEXIT_CRITICAL(&mux);}
+// due to the dual core esp32, a critical section works better than disabling interrupts.
+// It masks interrupts on this core and takes the spinlock of the bus, so a
+// task on the other core using the same bus waits for the slot to end.
+#  undef noInterrupts
+#  undef interrupts
+#  define noInterrupts() portENTER_CRITICAL(&mux)
+#  define interrupts() portEXIT_CRITICAL(&mux)
 // for info on this, search "IRAM_ATTR" at https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-guides/general-notes.html 
 #  define CRIT_TIMING IRAM_ATTR
 #else
@@ -159,16 +163,72 @@ sample code bearing this copyright.
 #endif
 
 
+// Unbound until begin(): no pin, no backend
+OneWire::OneWire()
+{
+	bitmask = 0;
+	baseReg = 0;
+#ifdef ARDUINO_ARCH_ESP32
+	portMUX_INITIALIZE(&mux);
+#endif
+#if ONEWIRE_BACKEND
+	backend = nullptr;
+#endif
+#if ONEWIRE_SEARCH
+	reset_search();
+#endif
+}
+
 void OneWire::begin(uint8_t pin)
 {
 	pinMode(pin, INPUT);
 	bitmask = PIN_TO_BITMASK(pin);
 	baseReg = PIN_TO_BASEREG(pin);
+#ifdef ARDUINO_ARCH_ESP32
+	portMUX_INITIALIZE(&mux);
+#endif
+#if ONEWIRE_BACKEND
+	backend = nullptr;
+#endif
 #if ONEWIRE_SEARCH
 	reset_search();
 #endif
 }
 
+#if ONEWIRE_BACKEND
+void OneWire::begin(OneWireBackend *b)
+{
+	bitmask = 0;
+	baseReg = 0;
+#ifdef ARDUINO_ARCH_ESP32
+	portMUX_INITIALIZE(&mux);
+#endif
+	backend = b;
+#if ONEWIRE_SEARCH
+	reset_search();
+#endif
+}
+
+bool OneWireBackend::transaction(bool rst, const uint8_t *wbuf, uint16_t wcount,
+                                 uint8_t *rbuf, uint16_t rcount)
+{
+	if (rst && !reset()) return false;
+	for (uint16_t i = 0; i < wcount; i++) {
+		for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+			write_bit((wbuf[i] & bitMask) ? 1 : 0);
+		}
+	}
+	for (uint16_t i = 0; i < rcount; i++) {
+		uint8_t r = 0;
+		for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+			if (read_bit()) r |= bitMask;
+		}
+		rbuf[i] = r;
+	}
+	return true;
+}
+#endif
+
 
 // Perform the onewire reset function.  We will wait up to 250uS for
 // the bus to come high, if it doesn't then it is broken or shorted
@@ -183,6 +243,9 @@ uint8_t CRIT_TIMING OneWire::reset(void)
 	uint8_t r;
 	uint8_t retries = 125;
 
+#if ONEWIRE_BACKEND
+	if (backend) return backend->reset();
+#endif
 	noInterrupts();
 	DIRECT_MODE_INPUT(reg, mask);
 	interrupts();
@@ -215,6 +278,12 @@ void CRIT_TIMING OneWire::write_bit(uint8_t v)
 	IO_REG_TYPE mask IO_REG_MASK_ATTR = bitmask;
 	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = baseReg;
 
+#if ONEWIRE_BACKEND
+	if (backend) {
+		backend->write_bit(v & 1);
+		return;
+	}
+#endif
 	if (v & 1) {
 		noInterrupts();
 		DIRECT_WRITE_LOW(reg, mask);
@@ -244,6 +313,9 @@ uint8_t CRIT_TIMING OneWire::read_bit(void)
 	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = baseReg;
 	uint8_t r;
 
+#if ONEWIRE_BACKEND
+	if (backend) return backend->read_bit();
+#endif
 	noInterrupts();
 	DIRECT_MODE_OUTPUT(reg, mask);
 	DIRECT_WRITE_LOW(reg, mask);
@@ -266,6 +338,13 @@ uint8_t CRIT_TIMING OneWire::read_bit(void)
 void OneWire::write(uint8_t v, uint8_t power /* = 0 */) {
     uint8_t bitMask;
 
+#if ONEWIRE_BACKEND
+    if (backend) {
+	backend->transaction(false, &v, 1, nullptr, 0);
+	if ( !power) backend->depower();
+	return;
+    }
+#endif
     for (bitMask = 0x01; bitMask; bitMask <<= 1) {
 	OneWire::write_bit( (bitMask & v)?1:0);
     }
@@ -278,6 +357,13 @@ void OneWire::write(uint8_t v, uint8_t power /* = 0 */) {
 }
 
 void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool power /* = 0 */) {
+#if ONEWIRE_BACKEND
+  if (backend) {
+    backend->transaction(false, buf, count, nullptr, 0);
+    if (!power) backend->depower();
+    return;
+  }
+#endif
   for (uint16_t i = 0 ; i < count ; i++)
     write(buf[i]);
   if (!power) {
@@ -295,6 +381,12 @@ uint8_t OneWire::read() {
     uint8_t bitMask;
     uint8_t r = 0;
 
+#if ONEWIRE_BACKEND
+    if (backend) {
+	backend->transaction(false, nullptr, 0, &r, 1);
+	return r;
+    }
+#endif
     for (bitMask = 0x01; bitMask; bitMask <<= 1) {
 	if ( OneWire::read_bit()) r |= bitMask;
     }
@@ -302,10 +394,28 @@ uint8_t OneWire::read() {
 }
 
 void OneWire::read_bytes(uint8_t *buf, uint16_t count) {
+#if ONEWIRE_BACKEND
+  if (backend) {
+    backend->transaction(false, nullptr, 0, buf, count);
+    return;
+  }
+#endif
   for (uint16_t i = 0 ; i < count ; i++)
     buf[i] = read();
 }
 
+bool OneWire::transaction(bool rst, const uint8_t *wbuf, uint16_t wcount,
+                          uint8_t *rbuf, uint16_t rcount)
+{
+#if ONEWIRE_BACKEND
+  if (backend) return backend->transaction(rst, wbuf, wcount, rbuf, rcount);
+#endif
+  if (rst && !reset()) return false;
+  write_bytes(wbuf, wcount);
+  read_bytes(rbuf, rcount);
+  return true;
+}
+
 //
 // Do a ROM select
 //
@@ -313,6 +423,15 @@ void OneWire::select(const uint8_t rom[8])
 {
     uint8_t i;
 
+#if ONEWIRE_BACKEND
+    if (backend) {
+	uint8_t buf[9];
+	buf[0] = 0x55;         // Choose ROM
+	memcpy(buf + 1, rom, 8);
+	write_bytes(buf, 9);
+	return;
+    }
+#endif
     write(0x55);           // Choose ROM
 
     for (i = 0; i < 8; i++) write(rom[i]);
@@ -328,6 +447,12 @@ void OneWire::skip()
 
 void OneWire::depower()
 {
+#if ONEWIRE_BACKEND
+	if (backend) {
+		backend->depower();
+		return;
+	}
+#endif
 	noInterrupts();
 	DIRECT_MODE_INPUT(baseReg, bitmask);
 	interrupts();
@@ -596,8 +721,8 @@ uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
 
 // undef defines for no particular reason
 #ifdef ARDUINO_ARCH_ESP32
-#  undef noInterrupts() {portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;portENTER_CRITICAL(&mux)
-#  undef interrupts() portEXIT_CRITICAL(&mux);}
+#  undef noInterrupts
+#  undef interrupts
 #endif
 // for info on this, search "IRAM_ATTR" at https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-guides/general-notes.html 
 #undef CRIT_TIMING 
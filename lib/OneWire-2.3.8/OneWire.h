@@ -51,14 +51,53 @@
 #define ONEWIRE_CRC16 1
 #endif
 
+// You can route the bit-level primitives through a OneWireBackend by
+// defining this to 1.  A OneWire bound to a backend never touches the
+// GPIO, which allows driving the bus with other hardware or with the
+// host-side simulator in OneWireSim.h.  The extra pointer test costs a
+// few cycles per bit, so it is off by default.
+#ifndef ONEWIRE_BACKEND
+#define ONEWIRE_BACKEND 0
+#endif
+
 // Board-specific macros for direct GPIO
 #include "util/OneWire_direct_regtype.h"
 
+#if ONEWIRE_BACKEND
+// Bit-level bus driver.  reset(), write_bit() and read_bit() have the
+// same meaning as the OneWire methods of the same name.  depower() is
+// called whenever the master stops actively holding the bus high.
+//
+// Byte reads and writes go through transaction(): an optional reset,
+// then 'wcount' bytes written and 'rcount' bytes read.  It returns
+// false if the reset found no device or the backend failed.  The
+// default clocks the bits one by one through the methods above; a
+// backend that can queue a whole sequence in hardware overrides it.
+class OneWireBackend
+{
+  public:
+    virtual ~OneWireBackend() { }
+    virtual uint8_t reset(void) = 0;
+    virtual void write_bit(uint8_t v) = 0;
+    virtual uint8_t read_bit(void) = 0;
+    virtual void depower(void) { }
+    virtual bool transaction(bool reset, const uint8_t *wbuf, uint16_t wcount,
+                             uint8_t *rbuf, uint16_t rcount);
+};
+#endif
+
 class OneWire
 {
   private:
     IO_REG_TYPE bitmask;
     volatile IO_REG_TYPE *baseReg;
+#ifdef ARDUINO_ARCH_ESP32
+    // spinlock of the critical sections around the bit timing
+    portMUX_TYPE mux;
+#endif
+#if ONEWIRE_BACKEND
+    OneWireBackend *backend;
+#endif
 
 #if ONEWIRE_SEARCH
     // global search state
@@ -69,9 +108,14 @@ class OneWire
 #endif
 
   public:
-    OneWire() { }
+    OneWire();
     OneWire(uint8_t pin) { begin(pin); }
     void begin(uint8_t pin);
+#if ONEWIRE_BACKEND
+    OneWire(OneWireBackend *b) { begin(b); }
+    // Drive the bus through a backend instead of a GPIO pin.
+    void begin(OneWireBackend *b);
+#endif
 
     // Perform a 1-Wire reset cycle. Returns 1 if a device responds
     // with a presence pulse.  Returns 0 if there is no device or the
@@ -97,6 +141,13 @@ class OneWire
 
     void read_bytes(uint8_t *buf, uint16_t count);
 
+    // Reset (if 'reset' is set), write 'wcount' bytes and read 'rcount'
+    // bytes in one go, e.g. reset, MATCH ROM, READ SCRATCHPAD and the nine
+    // scratchpad bytes.  Returns false if the reset got no presence pulse.
+    // A backend runs it as one transaction of its own.
+    bool transaction(bool reset, const uint8_t *wbuf, uint16_t wcount,
+                     uint8_t *rbuf, uint16_t rcount);
+
     // Write a bit. The bus is always left powered at the end, see
     // note in write() about that.
     void write_bit(uint8_t v);
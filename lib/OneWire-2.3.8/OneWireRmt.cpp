@@ -0,0 +1,240 @@
+// 1-Wire master on the ESP32 RMT peripheral, see OneWireRmt.h
+
+#include "OneWireRmt.h"
+
+#if ONEWIRE_BACKEND
+
+#include <string.h>
+
+// Durations in us, the channels count 1 us ticks
+#define RMT_RESET_LOW    480
+#define RMT_RESET_HIGH   480  // presence window and recovery
+#define RMT_SLOT         70
+#define RMT_ONE_LOW      6
+#define RMT_ZERO_LOW     60
+#define RMT_SAMPLE       15   // a read slot low for longer is a 0
+#define RMT_SLACK        5    // echo of a slot vs. its start in the transfer
+
+OneWireRmt::OneWireRmt(OneWireRmtLink *l)
+{
+	link = l;
+	errors = 0;
+	count = 0;
+	firstRead = ONEWIRE_RMT_ITEMS;
+	withReset = false;
+	presence = false;
+	readBuf = nullptr;
+	readBit = 0;
+}
+
+void OneWireRmt::start(bool rst, uint8_t *rbuf, uint16_t rcount)
+{
+	count = 0;
+	firstRead = ONEWIRE_RMT_ITEMS;
+	withReset = false;
+	presence = false;
+	readBuf = rbuf;
+	readBit = 0;
+	if (rcount) memset(rbuf, 0, rcount);
+	if (rst) {
+		queue(RMT_RESET_LOW, RMT_RESET_HIGH, false);
+		withReset = true;
+	}
+}
+
+// Add an item, sending the transfer first if it is full
+bool OneWireRmt::queue(uint16_t low, uint16_t high, bool read)
+{
+	if (count == ONEWIRE_RMT_ITEMS && !flush()) return false;
+	if (read && firstRead > count) firstRead = count;
+	items[count].level0 = 0;
+	items[count].duration0 = low;
+	items[count].level1 = 1;
+	items[count].duration1 = high;
+	count++;
+	return true;
+}
+
+bool OneWireRmt::flush(void)
+{
+	size_t n = ONEWIRE_RMT_ECHO;
+	bool ok;
+
+	if (count == 0) return true;
+
+	ok = link->transfer(items, count, withReset, echo, &n) && decode(echo, n);
+	if (!ok) errors++;
+
+	count = 0;
+	firstRead = ONEWIRE_RMT_ITEMS;
+	withReset = false;
+	return ok;
+}
+
+// Match the low pulses recorded with the items sent.  The first low is
+// items[0]: whatever high level the receiver caught before it is idle
+// bus.  A low pulse starting where the next item is due is that item's
+// echo, stretched by a device answering a read slot with a 0, and the
+// item after it is due a slot later.  Any other low pulse is a device on
+// its own: the presence pulse after a reset.
+bool OneWireRmt::decode(const OneWireRmtItem *rx, size_t n)
+{
+	uint32_t t = 0, next = 0;
+	uint8_t item = 0;
+	bool started = false;
+
+	for (size_t i = 0; i < n; i++) {
+		for (uint8_t half = 0; half < 2; half++) {
+			uint32_t level = half ? rx[i].level1 : rx[i].level0;
+			uint32_t duration = half ? rx[i].duration1 : rx[i].duration0;
+
+			if (duration == 0) return item == count;  // end of frame
+			if (level == 0) {
+				started = true;
+				if (item < count && t + RMT_SLACK >= next) {
+					if (item >= firstRead) {
+						if (duration <= RMT_SAMPLE) readBuf[readBit >> 3] |= 1 << (readBit & 7);
+						readBit++;
+					}
+					next = t + items[item].duration0 + items[item].duration1;
+					item++;
+				} else if (withReset && item == 1) {
+					presence = true;
+				}
+			}
+			if (started) t += duration;
+		}
+	}
+	return item == count;
+}
+
+bool OneWireRmt::transaction(bool rst, const uint8_t *wbuf, uint16_t wcount,
+                             uint8_t *rbuf, uint16_t rcount)
+{
+	bool ok = true;
+
+	start(rst, rbuf, rcount);
+	for (uint16_t i = 0; ok && i < wcount; i++) {
+		for (uint8_t bitMask = 0x01; ok && bitMask; bitMask <<= 1) {
+			if (wbuf[i] & bitMask) ok = queue(RMT_ONE_LOW, RMT_SLOT - RMT_ONE_LOW, false);
+			else ok = queue(RMT_ZERO_LOW, RMT_SLOT - RMT_ZERO_LOW, false);
+		}
+	}
+	for (uint16_t i = 0; ok && i < rcount * 8; i++) {
+		ok = queue(RMT_ONE_LOW, RMT_SLOT - RMT_ONE_LOW, true);
+	}
+	if (ok) ok = flush();
+	count = 0;
+	return ok && (!rst || presence);
+}
+
+uint8_t OneWireRmt::reset(void)
+{
+	return transaction(true, nullptr, 0, nullptr, 0) ? 1 : 0;
+}
+
+void OneWireRmt::write_bit(uint8_t v)
+{
+	uint8_t b = v & 1;
+
+	start(false, nullptr, 0);
+	queue(b ? RMT_ONE_LOW : RMT_ZERO_LOW, RMT_SLOT - (b ? RMT_ONE_LOW : RMT_ZERO_LOW), false);
+	flush();
+}
+
+uint8_t OneWireRmt::read_bit(void)
+{
+	uint8_t r = 0;
+
+	start(false, &r, 1);
+	queue(RMT_ONE_LOW, RMT_SLOT - RMT_ONE_LOW, true);
+	return flush() ? r : 1;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+
+#include <driver/gpio.h>
+#include <soc/gpio_periph.h>
+#include <soc/gpio_struct.h>
+#include <soc/io_mux_reg.h>
+
+// The receiver ends a frame after this long without an edge: longer than
+// any level inside a transfer, the reset low included when there is one
+#define RMT_IDLE_SLOT    (RMT_SLOT + 30)
+#define RMT_IDLE_RESET   (RMT_RESET_LOW + 40)
+
+#define RMT_CLK_DIV      80
+#define RMT_RX_BUFFER    512
+#define RMT_RX_FILTER    30   // APB cycles: glitches under 0.4 us
+#define RMT_TIMEOUT_MS   20
+
+OneWireRmtChannels::OneWireRmtChannels(uint8_t p, rmt_channel_t tx, rmt_channel_t rx)
+{
+	pin = p;
+	txChannel = tx;
+	rxChannel = rx;
+	ring = nullptr;
+}
+
+bool OneWireRmtChannels::begin(void)
+{
+	rmt_config_t tx = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, txChannel);
+	rmt_config_t rx = RMT_DEFAULT_CONFIG_RX((gpio_num_t)pin, rxChannel);
+
+	tx.clk_div = RMT_CLK_DIV;
+	tx.mem_block_num = 2;
+	tx.tx_config.idle_output_en = true;
+	tx.tx_config.idle_level = RMT_IDLE_LEVEL_HIGH;
+	rx.clk_div = RMT_CLK_DIV;
+	rx.mem_block_num = 2;
+	rx.rx_config.filter_en = true;
+	rx.rx_config.filter_ticks_thresh = RMT_RX_FILTER;
+	rx.rx_config.idle_threshold = RMT_IDLE_RESET;
+
+	// RX first: configuring TX afterwards keeps its output in the matrix
+	if (rmt_config(&rx) != ESP_OK || rmt_config(&tx) != ESP_OK) return false;
+	if (rmt_driver_install(rxChannel, RMT_RX_BUFFER, 0) != ESP_OK) return false;
+	if (rmt_driver_install(txChannel, 0, 0) != ESP_OK ||
+	    rmt_get_ringbuf_handle(rxChannel, &ring) != ESP_OK) {
+		rmt_driver_uninstall(rxChannel);
+		return false;
+	}
+
+	// the TX channel left the pin a push-pull output: make it open drain
+	// and give the RX channel its input back
+	PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[pin]);
+	GPIO.pin[pin].pad_driver = 1;
+	gpio_pullup_en((gpio_num_t)pin);
+	return true;
+}
+
+bool OneWireRmtChannels::transfer(const OneWireRmtItem *items, uint8_t count, bool reset,
+                                  OneWireRmtItem *echo, size_t *n)
+{
+	rmt_item32_t *rx;
+	size_t size = 0;
+	bool ok;
+
+	// drop what a failed transfer may have left behind
+	while ((rx = (rmt_item32_t *)xRingbufferReceive(ring, &size, 0)) != nullptr) {
+		vRingbufferReturnItem(ring, rx);
+	}
+
+	rmt_set_rx_idle_thresh(rxChannel, reset ? RMT_IDLE_RESET : RMT_IDLE_SLOT);
+	rmt_rx_start(rxChannel, true);
+	ok = rmt_write_items(txChannel, items, count, true) == ESP_OK;
+	rx = nullptr;
+	if (ok) rx = (rmt_item32_t *)xRingbufferReceive(ring, &size, pdMS_TO_TICKS(RMT_TIMEOUT_MS));
+	rmt_rx_stop(rxChannel);
+	if (rx == nullptr) return false;
+
+	size /= sizeof(rmt_item32_t);
+	if (size > *n) size = *n;
+	memcpy(echo, rx, size * sizeof(rmt_item32_t));
+	*n = size;
+	vRingbufferReturnItem(ring, rx);
+	return true;
+}
+
+#endif // ARDUINO_ARCH_ESP32
+#endif // ONEWIRE_BACKEND
@@ -0,0 +1,127 @@
+#ifndef OneWireRmt_h
+#define OneWireRmt_h
+
+#include "OneWire.h"
+
+#if ONEWIRE_BACKEND
+
+// 1-Wire master on the ESP32 RMT peripheral.  A TX channel clocks out
+// the reset pulse and the time slots, an RX channel on the same pin
+// records the bus, and each bit read is decoded from the length of its
+// low pulse.  A transaction (reset, MATCH ROM, command, scratchpad) is
+// handed to the peripheral as a whole: the calling task sleeps on the
+// driver's semaphores while the slots go out, instead of spinning in
+// delayMicroseconds() for 70 us per bit with interrupts masked.
+//
+// The pin is driven open drain and needs the usual external pull-up.
+// Parasite power is not supported: an open drain output can't give the
+// strong pull-up a parasite device needs while it converts.
+//
+// OneWireRmt builds the slots and decodes what the bus did during them;
+// the hardware is behind OneWireRmtLink, so the encoder and decoder run
+// on the host against a simulated echo.  On the ESP32:
+//
+//   OneWireRmtChannels channels(pin);
+//   OneWireRmt rmt(&channels);
+//   if (channels.begin()) oneWire.begin(&rmt);
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <driver/rmt.h>
+typedef rmt_item32_t OneWireRmtItem;
+
+#ifndef ONEWIRE_RMT_TX_CHANNEL
+#define ONEWIRE_RMT_TX_CHANNEL RMT_CHANNEL_4
+#endif
+#ifndef ONEWIRE_RMT_RX_CHANNEL
+#define ONEWIRE_RMT_RX_CHANNEL RMT_CHANNEL_6
+#endif
+#else
+// same layout as the driver's rmt_item32_t
+typedef struct {
+    uint32_t duration0 : 15;
+    uint32_t level0 : 1;
+    uint32_t duration1 : 15;
+    uint32_t level1 : 1;
+} OneWireRmtItem;
+#endif
+
+// Slots per hardware transfer.  A slot is one RMT item and a transfer
+// must fit in the two memory blocks (128 items) of the RX channel.
+#define ONEWIRE_RMT_ITEMS 120
+
+// Items recorded per transfer: the slots, the presence pulse splitting
+// the reset item and a few glitches.
+#define ONEWIRE_RMT_ECHO 128
+
+// Send the items of a transfer and record the bus meanwhile.  'reset' is
+// set when items[0] is a reset pulse.  The levels recorded are stored in
+// 'echo', at most *n items, and *n set to how many; a zero duration ends
+// them early.  Returns false if the transfer failed or timed out.
+class OneWireRmtLink
+{
+  public:
+    virtual ~OneWireRmtLink() { }
+    virtual bool transfer(const OneWireRmtItem *items, uint8_t count, bool reset,
+                          OneWireRmtItem *echo, size_t *n) = 0;
+};
+
+class OneWireRmt : public OneWireBackend
+{
+  public:
+    OneWireRmt(OneWireRmtLink *link);
+
+    // Transfers that failed or whose echo didn't match the slots sent
+    uint32_t errors;
+
+    // OneWireBackend
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+    bool transaction(bool reset, const uint8_t *wbuf, uint16_t wcount,
+                     uint8_t *rbuf, uint16_t rcount);
+
+  private:
+    OneWireRmtLink *link;
+
+    // the transfer being built
+    OneWireRmtItem items[ONEWIRE_RMT_ITEMS];
+    OneWireRmtItem echo[ONEWIRE_RMT_ECHO];
+    uint8_t count;
+    uint8_t firstRead;  // items from here on are read slots
+    bool withReset;     // items[0] is a reset pulse
+    bool presence;
+    uint8_t *readBuf;
+    uint16_t readBit;
+
+    void start(bool reset, uint8_t *rbuf, uint16_t rcount);
+    bool queue(uint16_t low, uint16_t high, bool read);
+    bool flush(void);
+    bool decode(const OneWireRmtItem *rx, size_t n);
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+// The RMT channels on the bus pin, legacy driver/rmt.h API
+class OneWireRmtChannels : public OneWireRmtLink
+{
+  public:
+    OneWireRmtChannels(uint8_t pin,
+                       rmt_channel_t tx = ONEWIRE_RMT_TX_CHANNEL,
+                       rmt_channel_t rx = ONEWIRE_RMT_RX_CHANNEL);
+
+    // Install the driver on both channels and route them to the pin.
+    // Returns false if the driver could not be installed.
+    bool begin(void);
+
+    bool transfer(const OneWireRmtItem *items, uint8_t count, bool reset,
+                  OneWireRmtItem *echo, size_t *n);
+
+  private:
+    uint8_t pin;
+    rmt_channel_t txChannel;
+    rmt_channel_t rxChannel;
+    RingbufHandle_t ring;
+};
+#endif
+
+#endif // ONEWIRE_BACKEND
+#endif // OneWireRmt_h
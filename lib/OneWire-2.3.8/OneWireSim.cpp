@@ -0,0 +1,465 @@
+// Bit-level 1-Wire bus simulator, see OneWireSim.h
+
+#include "OneWireSim.h"
+
+#if ONEWIRE_BACKEND
+
+#include <math.h>
+
+// Nominal slot durations used to account for bus time
+#define SIM_RESET_US   960
+#define SIM_SLOT_US     70
+
+// Scratchpad locations
+#define SP_TEMP_LSB     0
+#define SP_TEMP_MSB     1
+#define SP_HIGH_ALARM   2
+#define SP_LOW_ALARM    3
+#define SP_CONFIG       4
+#define SP_COUNT_REMAIN 6
+#define SP_COUNT_PER_C  7
+#define SP_CRC          8
+
+#define FAMILY_DS18S20  0x10
+
+OneWireSim::OneWireSim()
+{
+	count = 0;
+	state = IDLE;
+	shift = 0;
+	bitIndex = 0;
+	searchPhase = 0;
+	byteIndex = 0;
+	powered = false;
+	now = 0;
+	clock = nullptr;
+	resets = 0;
+	slots = 0;
+	busMicros = 0;
+	conversions = 0;
+	failedConversions = 0;
+}
+
+int OneWireSim::addDevice(uint8_t family, uint64_t serial, bool parasite)
+{
+	if (count >= ONEWIRE_SIM_DEVICES) return -1;
+
+	Device &d = devices[count];
+	d.rom[0] = family;
+	for (uint8_t i = 1; i < 7; i++) {
+		d.rom[i] = serial & 0xFF;
+		serial >>= 8;
+	}
+	d.rom[7] = OneWire::crc8(d.rom, 7);
+
+	// power-on state: 85 C, TH 75 C, TL 70 C, 12 bit
+	d.eeprom[0] = 0x4B;
+	d.eeprom[1] = 0x46;
+	d.eeprom[2] = 0x7F;
+	d.scratch[SP_HIGH_ALARM] = d.eeprom[0];
+	d.scratch[SP_LOW_ALARM] = d.eeprom[1];
+	if (family == FAMILY_DS18S20) {
+		d.scratch[SP_CONFIG] = 0xFF;
+		d.scratch[5] = 0xFF;
+		d.scratch[SP_COUNT_REMAIN] = 0x0C;
+	} else {
+		d.scratch[SP_CONFIG] = d.eeprom[2];
+		d.scratch[5] = 0xFF;
+		d.scratch[SP_COUNT_REMAIN] = 0x0C;
+	}
+	d.scratch[SP_COUNT_PER_C] = 0x10;
+	d.celsius = 85.0f;
+	loadTemperature(d);
+
+	d.connected = true;
+	d.parasite = parasite;
+	d.active = false;
+	d.converting = false;
+	d.powerLost = false;
+	d.convEnd = 0;
+	d.crcFaults = 0;
+
+	return count++;
+}
+
+void OneWireSim::setConnected(int index, bool connected)
+{
+	if (index < 0 || index >= count) return;
+	devices[index].connected = connected;
+	if (!connected) {
+		devices[index].active = false;
+		devices[index].converting = false;
+	}
+}
+
+void OneWireSim::setTemperature(int index, float celsius)
+{
+	if (index < 0 || index >= count) return;
+	devices[index].celsius = celsius;
+}
+
+void OneWireSim::injectCrcFaults(int index, uint16_t faults)
+{
+	if (index < 0 || index >= count) return;
+	devices[index].crcFaults = faults;
+}
+
+const uint8_t *OneWireSim::rom(int index) const
+{
+	if (index < 0 || index >= count) return nullptr;
+	return devices[index].rom;
+}
+
+void OneWireSim::advance(uint32_t us)
+{
+	now += us;
+}
+
+void OneWireSim::setClock(uint32_t (*c)(void))
+{
+	clock = c;
+}
+
+uint32_t OneWireSim::micros(void) const
+{
+	return clock ? clock() : now;
+}
+
+void OneWireSim::spend(uint32_t us)
+{
+	busMicros += us;
+	now += us;
+}
+
+// Complete the conversions whose latency has elapsed.
+void OneWireSim::settle(void)
+{
+	uint32_t t = micros();
+
+	for (uint8_t i = 0; i < count; i++) {
+		Device &d = devices[i];
+		if (!d.converting || (int32_t)(t - d.convEnd) < 0) continue;
+		d.converting = false;
+		if (d.powerLost) {
+			// brown-out: the device comes back with its power-on value
+			float celsius = d.celsius;
+			d.celsius = 85.0f;
+			loadTemperature(d);
+			d.celsius = celsius;
+			failedConversions++;
+		} else {
+			loadTemperature(d);
+		}
+	}
+}
+
+// The master released the bus, parasite devices still converting starve.
+void OneWireSim::powerOff(void)
+{
+	if (powered) {
+		for (uint8_t i = 0; i < count; i++) {
+			if (devices[i].converting && devices[i].parasite)
+				devices[i].powerLost = true;
+		}
+	}
+	powered = false;
+}
+
+uint8_t OneWireSim::reset(void)
+{
+	settle();
+	powerOff();
+	spend(SIM_RESET_US);
+	resets++;
+
+	uint8_t presence = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		devices[i].active = devices[i].connected;
+		if (devices[i].connected) presence = 1;
+	}
+	state = presence ? ROM_COMMAND : IDLE;
+	shift = 0;
+	bitIndex = 0;
+	return presence;
+}
+
+void OneWireSim::write_bit(uint8_t v)
+{
+	settle();
+	spend(SIM_SLOT_US);
+	slots++;
+	powered = true;
+	v &= 1;
+
+	switch (state) {
+	case ROM_COMMAND:
+	case FUNCTION:
+	case WRITE_SCRATCH:
+		shift |= v << bitIndex;
+		if (++bitIndex < 8) break;
+		bitIndex = 0;
+		{
+			uint8_t b = shift;
+			shift = 0;
+			if (state == ROM_COMMAND) romCommand(b);
+			else if (state == FUNCTION) functionCommand(b);
+			else receiveScratch(b);
+		}
+		break;
+
+	case MATCH_ROM:
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (d.active && ((d.rom[bitIndex >> 3] >> (bitIndex & 7)) & 1) != v)
+				d.active = false;
+		}
+		if (++bitIndex == 64) {
+			bitIndex = 0;
+			state = FUNCTION;
+		}
+		break;
+
+	case SEARCH_ROM:
+		if (searchPhase != 2) break;
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (d.active && ((d.rom[bitIndex >> 3] >> (bitIndex & 7)) & 1) != v)
+				d.active = false;
+		}
+		searchPhase = 0;
+		if (++bitIndex == 64) {
+			bitIndex = 0;
+			state = FUNCTION;
+		}
+		break;
+
+	default:
+		// a write-1 slot is indistinguishable from a read slot, the
+		// devices that are talking simply ignore it
+		break;
+	}
+}
+
+uint8_t OneWireSim::read_bit(void)
+{
+	settle();
+	powerOff();
+	spend(SIM_SLOT_US);
+	slots++;
+
+	// open drain: the bus reads 0 as soon as one device pulls it low
+	uint8_t r = 1;
+
+	switch (state) {
+	case SEARCH_ROM:
+		if (searchPhase > 1) break;
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (!d.active) continue;
+			uint8_t b = (d.rom[bitIndex >> 3] >> (bitIndex & 7)) & 1;
+			r &= searchPhase ? !b : b;
+		}
+		searchPhase++;
+		break;
+
+	case READ_ROM:
+		for (uint8_t i = 0; i < count; i++) {
+			if (devices[i].active)
+				r &= (devices[i].rom[bitIndex >> 3] >> (bitIndex & 7)) & 1;
+		}
+		if (++bitIndex == 64) state = IDLE;
+		break;
+
+	case READ_SCRATCH:
+		if (bitIndex >= 72) break;  // past the CRC the devices send ones
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (!d.active) continue;
+			uint8_t byte = d.scratch[bitIndex >> 3];
+			// a pending fault flips the first temperature bit
+			if (bitIndex == 0 && d.crcFaults) byte ^= 0x01;
+			r &= (byte >> (bitIndex & 7)) & 1;
+		}
+		bitIndex++;
+		if (bitIndex == 72) {
+			for (uint8_t i = 0; i < count; i++) {
+				if (devices[i].active && devices[i].crcFaults)
+					devices[i].crcFaults--;
+			}
+		}
+		break;
+
+	case READ_POWER:
+		for (uint8_t i = 0; i < count; i++) {
+			if (devices[i].active && devices[i].parasite) r = 0;
+		}
+		break;
+
+	case CONVERTING:
+		// externally powered devices hold the bus low until done
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (d.active && d.converting && !d.parasite) r = 0;
+		}
+		break;
+
+	default:
+		break;
+	}
+	return r;
+}
+
+void OneWireSim::depower(void)
+{
+	settle();
+	powerOff();
+}
+
+void OneWireSim::romCommand(uint8_t cmd)
+{
+	switch (cmd) {
+	case 0x33:  // READ ROM
+		state = READ_ROM;
+		break;
+	case 0x55:  // MATCH ROM
+		state = MATCH_ROM;
+		break;
+	case 0xCC:  // SKIP ROM
+		state = FUNCTION;
+		break;
+	case 0xEC:  // ALARM SEARCH
+		for (uint8_t i = 0; i < count; i++) {
+			if (devices[i].active && !hasAlarm(devices[i]))
+				devices[i].active = false;
+		}
+		// fall through
+	case 0xF0:  // SEARCH ROM
+		state = SEARCH_ROM;
+		searchPhase = 0;
+		break;
+	default:
+		state = IDLE;
+		break;
+	}
+}
+
+void OneWireSim::functionCommand(uint8_t cmd)
+{
+	uint32_t t = micros();
+
+	switch (cmd) {
+	case 0x44:  // CONVERT T
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (!d.active) continue;
+			d.converting = true;
+			d.powerLost = false;
+			d.convEnd = t + conversionMicros(d);
+			conversions++;
+		}
+		state = CONVERTING;
+		break;
+	case 0xBE:  // READ SCRATCHPAD
+		state = READ_SCRATCH;
+		break;
+	case 0x4E:  // WRITE SCRATCHPAD
+		state = WRITE_SCRATCH;
+		byteIndex = 0;
+		break;
+	case 0x48:  // COPY SCRATCHPAD
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (!d.active) continue;
+			d.eeprom[0] = d.scratch[SP_HIGH_ALARM];
+			d.eeprom[1] = d.scratch[SP_LOW_ALARM];
+			if (d.rom[0] != FAMILY_DS18S20) d.eeprom[2] = d.scratch[SP_CONFIG];
+		}
+		state = IDLE;
+		break;
+	case 0xB8:  // RECALL E2
+		for (uint8_t i = 0; i < count; i++) {
+			Device &d = devices[i];
+			if (!d.active) continue;
+			d.scratch[SP_HIGH_ALARM] = d.eeprom[0];
+			d.scratch[SP_LOW_ALARM] = d.eeprom[1];
+			if (d.rom[0] != FAMILY_DS18S20) d.scratch[SP_CONFIG] = d.eeprom[2];
+			updateCrc(d);
+		}
+		state = RECALLING;
+		break;
+	case 0xB4:  // READ POWER SUPPLY
+		state = READ_POWER;
+		break;
+	default:
+		state = IDLE;
+		break;
+	}
+}
+
+void OneWireSim::receiveScratch(uint8_t v)
+{
+	static const uint8_t order[3] = { SP_HIGH_ALARM, SP_LOW_ALARM, SP_CONFIG };
+	uint8_t n = byteIndex++;
+
+	for (uint8_t i = 0; i < count; i++) {
+		Device &d = devices[i];
+		if (!d.active) continue;
+		if (n == 2 && d.rom[0] == FAMILY_DS18S20) continue;
+		if (n > 2) continue;
+		if (order[n] == SP_CONFIG)
+			d.scratch[SP_CONFIG] = (v & 0x60) | 0x1F;
+		else
+			d.scratch[order[n]] = v;
+		updateCrc(d);
+	}
+	if (n >= 2) state = IDLE;
+}
+
+// Encode the current temperature into the scratchpad.
+void OneWireSim::loadTemperature(Device &d)
+{
+	if (d.rom[0] == FAMILY_DS18S20) {
+		// 9 bit register plus COUNT_REMAIN for the extended resolution
+		int16_t whole = (int16_t)floorf(d.celsius + 0.25f);
+		int16_t remain = 16 - (int16_t)lroundf((d.celsius - whole + 0.25f) * 16.0f);
+		if (remain < 0) remain = 0;
+		int16_t raw = whole * 2;
+		d.scratch[SP_TEMP_LSB] = raw & 0xFF;
+		d.scratch[SP_TEMP_MSB] = (raw >> 8) & 0xFF;
+		d.scratch[SP_COUNT_REMAIN] = remain;
+		d.scratch[SP_COUNT_PER_C] = 0x10;
+	} else {
+		// 1/16 C, undefined low bits cleared for lower resolutions
+		int16_t raw = (int16_t)lroundf(d.celsius * 16.0f);
+		uint8_t bits = 9 + ((d.scratch[SP_CONFIG] >> 5) & 0x03);
+		raw &= ~((1 << (12 - bits)) - 1);
+		d.scratch[SP_TEMP_LSB] = raw & 0xFF;
+		d.scratch[SP_TEMP_MSB] = (raw >> 8) & 0xFF;
+	}
+	updateCrc(d);
+}
+
+void OneWireSim::updateCrc(Device &d)
+{
+	d.scratch[SP_CRC] = OneWire::crc8(d.scratch, 8);
+}
+
+bool OneWireSim::hasAlarm(const Device &d) const
+{
+	int8_t t = (int8_t)(((int16_t)(d.scratch[SP_TEMP_MSB] << 8) | d.scratch[SP_TEMP_LSB])
+		>> (d.rom[0] == FAMILY_DS18S20 ? 1 : 4));
+	return t >= (int8_t)d.scratch[SP_HIGH_ALARM] || t <= (int8_t)d.scratch[SP_LOW_ALARM];
+}
+
+uint32_t OneWireSim::conversionMicros(const Device &d) const
+{
+	if (d.rom[0] == FAMILY_DS18S20) return 750000;
+	switch ((d.scratch[SP_CONFIG] >> 5) & 0x03) {
+	case 0:  return 93750;
+	case 1:  return 187500;
+	case 2:  return 375000;
+	default: return 750000;
+	}
+}
+
+#endif // ONEWIRE_BACKEND
@@ -0,0 +1,125 @@
+#ifndef OneWireSim_h
+#define OneWireSim_h
+
+#include "OneWire.h"
+
+#if ONEWIRE_BACKEND
+
+// Bit-level simulation of a 1-Wire bus populated with DS18B20 and
+// DS18S20 temperature sensors.  Bind it to a OneWire with
+// OneWire(&sim) and the unmodified OneWire / DallasTemperature code
+// runs against it, which lets the sensor stack be exercised on a host
+// with no hardware.
+//
+// The model covers the ROM layer (READ ROM, MATCH ROM, SKIP ROM,
+// SEARCH ROM, ALARM SEARCH, with wired-AND collisions), the function
+// layer (CONVERT T, READ/WRITE/COPY/RECALL SCRATCHPAD, READ POWER
+// SUPPLY), conversion latency for each resolution, parasite power and
+// CRC fault injection.
+//
+// Time is kept in microseconds.  Every reset and time slot advances the
+// simulated clock by its nominal duration; the caller advances it
+// further with advance(), or replaces it by an external clock with
+// setClock().  busMicros accumulates the time the bus was in use.
+
+#ifndef ONEWIRE_SIM_DEVICES
+#define ONEWIRE_SIM_DEVICES 8
+#endif
+
+class OneWireSim : public OneWireBackend
+{
+  public:
+    OneWireSim();
+
+    // Add a device with family code 0x28 (DS18B20) or 0x10 (DS18S20) and
+    // a 48 bit serial number.  Returns its index, or -1 if the bus is full.
+    int addDevice(uint8_t family, uint64_t serial, bool parasite = false);
+
+    // Plug or unplug a device without forgetting its state.
+    void setConnected(int index, bool connected);
+
+    // Temperature the device reports on its next conversion.
+    void setTemperature(int index, float celsius);
+
+    // Corrupt one bit of the next 'count' scratchpad reads of a device.
+    void injectCrcFaults(int index, uint16_t count);
+
+    // ROM code of a device, CRC included.
+    const uint8_t *rom(int index) const;
+
+    uint8_t deviceCount(void) const { return count; }
+
+    // Simulated time
+    void advance(uint32_t us);
+    void setClock(uint32_t (*clock)(void));
+    uint32_t micros(void) const;
+
+    // Bus statistics
+    uint32_t resets;
+    uint32_t slots;
+    uint32_t busMicros;
+    uint32_t conversions;
+    uint32_t failedConversions;
+
+    // OneWireBackend
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+    void depower(void);
+
+  private:
+    enum State {
+      IDLE,           // no reset seen, or transaction finished
+      ROM_COMMAND,    // receiving the ROM command byte
+      MATCH_ROM,      // receiving 64 ROM bits
+      SEARCH_ROM,     // bit, complement, direction
+      READ_ROM,       // sending 64 ROM bits
+      FUNCTION,       // receiving the function command byte
+      WRITE_SCRATCH,  // receiving TH, TL (and config)
+      READ_SCRATCH,   // sending 9 scratchpad bytes
+      READ_POWER,     // sending the power supply bit
+      CONVERTING,     // read slots report conversion status
+      RECALLING       // read slots report recall status
+    };
+
+    struct Device {
+      uint8_t rom[8];
+      uint8_t scratch[9];
+      uint8_t eeprom[3];  // TH, TL, config
+      float celsius;
+      bool connected;
+      bool parasite;
+      bool active;        // still addressed in the current transaction
+      bool converting;
+      bool powerLost;     // parasite device lost power while converting
+      uint32_t convEnd;
+      uint16_t crcFaults;
+    };
+
+    Device devices[ONEWIRE_SIM_DEVICES];
+    uint8_t count;
+
+    State state;
+    uint8_t shift;      // bits received so far
+    uint16_t bitIndex;  // bit position within the current state
+    uint8_t searchPhase;
+    uint8_t byteIndex;  // bytes received by WRITE SCRATCHPAD
+    bool powered;
+
+    uint32_t now;
+    uint32_t (*clock)(void);
+
+    void spend(uint32_t us);
+    void settle(void);
+    void powerOff(void);
+    void romCommand(uint8_t cmd);
+    void functionCommand(uint8_t cmd);
+    void receiveScratch(uint8_t v);
+    void loadTemperature(Device &d);
+    void updateCrc(Device &d);
+    bool hasAlarm(const Device &d) const;
+    uint32_t conversionMicros(const Device &d) const;
+};
+
+#endif // ONEWIRE_BACKEND
+#endif // OneWireSim_h
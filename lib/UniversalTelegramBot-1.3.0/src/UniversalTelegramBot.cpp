@@ -23,14 +23,16 @@
    **** Note Regarding Client Connection Keeping ****
    Client connection is established in functions that directly involve use of
    client, i.e sendGetToTelegram, sendPostToTelegram, and
-   sendMultipartFormDataToTelegram. It is closed at the end of
-   sendMultipartFormDataToTelegram, but not at the end of sendGetToTelegram and
-   sendPostToTelegram as these may need to keep the connection alive for respose
-   / response checking. Re-establishing a connection then wastes time which is
-   noticeable in user experience. Due to this, it is important that connection
-   be closed manually after calling sendGetToTelegram or sendPostToTelegram by
-   calling closeClient(); Failure to close connection causes memory leakage and
-   SSL errors
+   sendMultipartFormDataToTelegram. Every exchange ends with closeClient(). With
+   keepAlive set, closeClient() leaves the TLS session open when the answer was
+   read completely (Content-Length framing, no "Connection: close"), so the next
+   request skips the handshake. Otherwise, and after any error, the session is
+   stopped; a session left half read causes SSL errors on the next request.
+
+   Requests run on two connections: pollConnection for getUpdates and other
+   queries, and the outgoing connection for messages. The latter is the same
+   client unless setSendClient() provides a second one, in which case sending
+   never waits behind a long poll.
  */
 
 #include "UniversalTelegramBot.h"
@@ -38,9 +40,185 @@
 #define ZERO_COPY(STR)    ((char*)STR.c_str())
 #define BOT_CMD(STR)      buildCommand(F(STR))
 
+// Fields of a getUpdates answer used by processResult()
+static const char UPDATES_FILTER[] PROGMEM = R"({"ok":true,"result":[{
+  "update_id":true,
+  "message":{"from":{"id":true,"first_name":true},"date":true,
+    "chat":{"id":true,"title":true},"message_id":true,"text":true,
+    "location":{"longitude":true,"latitude":true},"caption":true,
+    "document":{"file_id":true,"file_name":true},
+    "reply_to_message":{"message_id":true,"text":true}},
+  "channel_post":{"text":true,"date":true,"chat":{"id":true,"title":true},
+    "message_id":true},
+  "callback_query":{"id":true,"from":{"id":true,"first_name":true},
+    "data":true,"date":true,
+    "message":{"chat":{"id":true},"text":true,"message_id":true}},
+  "edited_message":{"from":{"id":true,"first_name":true},"date":true,
+    "chat":{"id":true,"title":true},"message_id":true,"text":true,
+    "location":{"longitude":true,"latitude":true}}}]})";
+
+/*
+   Reads an HTTP answer straight from the client. readHeaders() consumes the
+   header block and notes the framing (Content-Length or chunked), then read()
+   and readBytes() return the decoded body, so the reader can be handed to
+   deserializeJson() as a stream. Waiting for data sleeps pollDelay ms between
+   checks until timeout ms after construction.
+ */
+class TelegramAnswerReader {
+public:
+  TelegramAnswerReader(Client &client, unsigned long timeout, unsigned int pollDelay)
+    : client(client), started(millis()), timeout(timeout), pollDelay(pollDelay),
+      contentLength(-1), remaining(0), chunked(false), closeRequested(false),
+      chunkSeen(false), done(false), failed(false) {}
+
+  // Returns false if no complete header block arrived
+  bool readHeaders(String *headers) {
+    String line;
+    for (;;) {
+      int c = next();
+      if (c < 0) return false;
+      if (headers) *headers += (char)c;
+      if (c != '\n') {
+        if (c != '\r') line += (char)c;
+        continue;
+      }
+      if (line.length() == 0) break;
+      line.toLowerCase();
+      if (line.startsWith(F("content-length:")))
+        contentLength = line.substring(15).toInt();
+      else if (line.startsWith(F("transfer-encoding:")) && line.indexOf("chunked") > 0)
+        chunked = true;
+      else if (line.startsWith(F("connection:")) && line.indexOf("close") > 0)
+        closeRequested = true;
+      line = "";
+    }
+    if (chunked) contentLength = -1;
+    remaining = chunked ? 0 : contentLength;
+    done = contentLength == 0;
+    return true;
+  }
+
+  int read() {
+    if (done) return -1;
+    if (chunked && remaining == 0 && !nextChunk()) return -1;
+    int c = next();
+    if (c < 0) {
+      // without framing the body ends when the server closes
+      if (contentLength < 0 && !chunked) done = true;
+      else failed = true;
+      return -1;
+    }
+    if (remaining > 0) remaining--;
+    if (!chunked && contentLength >= 0 && remaining == 0) done = true;
+    return c;
+  }
+
+  size_t readBytes(char *buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      int c = read();
+      if (c < 0) break;
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+
+  // Discard what is left of the body
+  void drain() {
+    while (read() >= 0) {}
+  }
+
+  // True if the whole answer was consumed and the server keeps the session
+  bool reusable() const {
+    return done && !failed && (chunked || contentLength >= 0) && !closeRequested;
+  }
+
+private:
+  Client &client;
+  unsigned long started;
+  unsigned long timeout;
+  unsigned int pollDelay;
+  long contentLength;
+  long remaining;
+  bool chunked;
+  bool closeRequested;
+  bool chunkSeen;
+  bool done;
+  bool failed;
+
+  int next() {
+    while (!client.available()) {
+      if (!client.connected() || millis() - started >= timeout) return -1;
+      // During a long poll the server may hold the request for longPoll
+      // seconds, sleep instead of spinning on the socket so the CPU is
+      // given back to other tasks.
+      delay(pollDelay);
+    }
+    return client.read();
+  }
+
+  // Reads the next chunk size line, and the trailer after the last chunk
+  bool nextChunk() {
+    if (chunkSeen) {
+      // CRLF closing the previous chunk
+      if (next() != '\r' || next() != '\n') return fail();
+    }
+    chunkSeen = true;
+
+    long size = 0;
+    bool extension = false;
+    for (;;) {
+      int c = next();
+      if (c < 0) return fail();
+      if (c == '\n') break;
+      if (c == ';') extension = true;
+      if (extension) continue;
+      if (c >= '0' && c <= '9') size = size * 16 + c - '0';
+      else if (c >= 'a' && c <= 'f') size = size * 16 + c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') size = size * 16 + c - 'A' + 10;
+    }
+
+    if (size == 0) {
+      // skip the trailer up to the blank line
+      int length = 0;
+      for (;;) {
+        int c = next();
+        if (c < 0) return fail();
+        if (c == '\n') {
+          if (length == 0) break;
+          length = 0;
+        } else if (c != '\r') {
+          length++;
+        }
+      }
+      done = true;
+      return false;
+    }
+    remaining = size;
+    return true;
+  }
+
+  bool fail() {
+    failed = true;
+    return false;
+  }
+};
+
 UniversalTelegramBot::UniversalTelegramBot(const String& token, Client &client) {
   updateToken(token);
   this->client = &client;
+  pollConnection.client = &client;
+  pollConnection.reusable = false;
+  sendConnection.client = &client;
+  sendConnection.reusable = false;
+  outgoing = &pollConnection;
+}
+
+// Use a dedicated client for outgoing messages
+void UniversalTelegramBot::setSendClient(Client &client) {
+  sendConnection.client = &client;
+  sendConnection.reusable = false;
+  outgoing = &sendConnection;
 }
 
 void UniversalTelegramBot::updateToken(const String& token) {
@@ -63,122 +241,133 @@ String UniversalTelegramBot::buildCommand(const String& cmd) {
 }
 
 String UniversalTelegramBot::sendGetToTelegram(const String& command) {
-  String body, headers;
-  
-  // Connect with api.telegram.org if not already connected
-  if (!client->connected()) {
+  return sendGetToTelegram(pollConnection, command);
+}
+
+// Connect with api.telegram.org if not already connected.
+// Returns true if an already open session is being reused.
+bool UniversalTelegramBot::connectClient(TelegramConnection &conn) {
+  if (conn.client->connected()) return true;
+
+  #ifdef TELEGRAM_DEBUG  
+      Serial.println(F("[BOT]Connecting to server"));
+  #endif
+  if (!conn.client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
     #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT]Connecting to server"));
+      Serial.println(F("[BOT]Conection error"));
     #endif
-    if (!client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT]Conection error"));
-      #endif
-    }
   }
-  if (client->connected()) {
+  return false;
+}
 
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println("sending: " + command);
-    #endif  
+void UniversalTelegramBot::writeGetRequest(TelegramConnection &conn, const String& command) {
+  #ifdef TELEGRAM_DEBUG  
+      Serial.println("sending: " + command);
+  #endif  
+
+  conn.client->print(F("GET /"));
+  conn.client->print(command);
+  conn.client->println(F(" HTTP/1.1"));
+  conn.client->println(F("Host:" TELEGRAM_HOST));
+  conn.client->println(F("Accept: application/json"));
+  conn.client->println(F("Cache-Control: no-cache"));
+  conn.client->println(keepAlive ? F("Connection: keep-alive") : F("Connection: close"));
+  conn.client->println();
+}
 
-    client->print(F("GET /"));
-    client->print(command);
-    client->println(F(" HTTP/1.1"));
-    client->println(F("Host:" TELEGRAM_HOST));
-    client->println(F("Accept: application/json"));
-    client->println(F("Cache-Control: no-cache"));
-    client->println();
+String UniversalTelegramBot::sendGetToTelegram(TelegramConnection &conn, const String& command) {
+  String body, headers;
 
-    readHTTPAnswer(body, headers);
+  // A kept-alive session may have been dropped by the server in the
+  // meantime, in that case retry once on a fresh connection
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = connectClient(conn);
+    if (!conn.client->connected()) break;
+
+    writeGetRequest(conn, command);
+
+    if (readHTTPAnswer(conn, body, headers) || !reused) break;
+    conn.client->stop();
   }
 
   return body;
 }
 
 bool UniversalTelegramBot::readHTTPAnswer(String &body, String &headers) {
-  int ch_count = 0;
-  unsigned long now = millis();
-  bool finishedHeaders = false;
-  bool currentLineIsBlank = true;
-  bool responseReceived = false;
-
-  while (millis() - now < longPoll * 1000 + waitForResponse) {
-    while (client->available()) {
-      char c = client->read();
-      responseReceived = true;
-
-      if (!finishedHeaders) {
-        if (currentLineIsBlank && c == '\n') {
-          finishedHeaders = true;
-        } else {
-          headers += c;
-        }
-      } else {
-        if (ch_count < maxMessageLength) {
-          body += c;
-          ch_count++;
-        }
-      }
+  return readHTTPAnswer(pollConnection, body, headers);
+}
 
-      if (c == '\n') currentLineIsBlank = true;
-      else if (c != '\r') currentLineIsBlank = false;
-    }
+// Reads headers and body of an answer. The body is read completely (bytes
+// beyond maxMessageLength are dropped) so the session is left clean for the
+// next request.
+bool UniversalTelegramBot::readHTTPAnswer(TelegramConnection &conn, String &body, String &headers) {
+  TelegramAnswerReader reader(*conn.client, longPoll * 1000 + waitForResponse, socketPollDelay);
 
-    if (responseReceived) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println();
-        Serial.println(body);
-        Serial.println();
-      #endif
-      break;
+  conn.reusable = false;
+  if (!reader.readHeaders(&headers)) return headers.length() > 0;
+
+  int ch_count = 0;
+  int c;
+  while ((c = reader.read()) >= 0) {
+    if (ch_count < maxMessageLength) {
+      body += (char)c;
+      ch_count++;
     }
   }
-  return responseReceived;
+  conn.reusable = reader.reusable();
+
+  #ifdef TELEGRAM_DEBUG  
+    Serial.println();
+    Serial.println(body);
+    Serial.println();
+  #endif
+  return true;
 }
 
 String UniversalTelegramBot::sendPostToTelegram(const String& command, JsonObject payload) {
+  return sendPostToTelegram(pollConnection, command, payload);
+}
+
+String UniversalTelegramBot::sendPostToTelegram(TelegramConnection &conn, const String& command, JsonObject payload) {
 
   String body;
   String headers;
 
-  // Connect with api.telegram.org if not already connected
-  if (!client->connected()) {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Connecting to server"));
-    #endif
-    if (!client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Conection error"));
-      #endif
-    }
-  }
-  if (client->connected()) {
+  // A kept-alive session may have been dropped by the server in the
+  // meantime, in that case retry once on a fresh connection
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = connectClient(conn);
+    if (!conn.client->connected()) break;
+
     // POST URI
-    client->print(F("POST /"));
-    client->print(command);
-    client->println(F(" HTTP/1.1"));
+    conn.client->print(F("POST /"));
+    conn.client->print(command);
+    conn.client->println(F(" HTTP/1.1"));
     // Host header
-    client->println(F("Host:" TELEGRAM_HOST));
+    conn.client->println(F("Host:" TELEGRAM_HOST));
+    conn.client->println(keepAlive ? F("Connection: keep-alive") : F("Connection: close"));
     // JSON content type
-    client->println(F("Content-Type: application/json"));
+    conn.client->println(F("Content-Type: application/json"));
 
     // Content length
     int length = measureJson(payload);
-    client->print(F("Content-Length:"));
-    client->println(length);
+    conn.client->print(F("Content-Length:"));
+    conn.client->println(length);
     // End of headers
-    client->println();
+    conn.client->println();
     // POST message body
     String out;
     serializeJson(payload, out);
     
-    client->println(out);
+    // no trailing line break, a kept-alive session would read it as the
+    // start of the next request
+    conn.client->print(out);
     #ifdef TELEGRAM_DEBUG
         Serial.println(String("Posting:") + out);
     #endif
 
-    readHTTPAnswer(body, headers);
+    if (readHTTPAnswer(conn, body, headers) || !reused) break;
+    conn.client->stop();
   }
 
   return body;
@@ -196,6 +385,7 @@ String UniversalTelegramBot::sendMultipartFormDataToTelegram(
   String headers;
   
   const String boundary = F("------------------------b8f610217e83e29b");
+  Client *client = outgoing->client;
 
   // Connect with api.telegram.org if not already connected
   if (!client->connected()) {
@@ -292,10 +482,10 @@ String UniversalTelegramBot::sendMultipartFormDataToTelegram(
     #ifdef TELEGRAM_DEBUG  
         Serial.print("End request: " + end_request);
     #endif
-    readHTTPAnswer(body, headers);
+    readHTTPAnswer(*outgoing, body, headers);
   }
 
-  closeClient();
+  closeClient(*outgoing);
   return body;
 }
 
@@ -304,7 +494,7 @@ bool UniversalTelegramBot::getMe() {
   String response = sendGetToTelegram(BOT_CMD("getMe")); // receive reply from telegram.org
   DynamicJsonDocument doc(maxMessageLength);
   DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
-  closeClient();
+  closeClient(pollConnection);
 
   if (!error) {
     if (doc.containsKey("result")) {
@@ -334,7 +524,7 @@ bool UniversalTelegramBot::setMyCommands(const String& commandArray) {
   unsigned long sttime = millis();
 
   while (millis() - sttime < 8000ul) { // loop for a while to send the message
-    response = sendPostToTelegram(BOT_CMD("setMyCommands"), payload.as<JsonObject>());
+    response = sendPostToTelegram(pollConnection, BOT_CMD("setMyCommands"), payload.as<JsonObject>());
     #ifdef _debug  
     Serial.println("setMyCommands response" + response);
     #endif
@@ -342,11 +532,19 @@ bool UniversalTelegramBot::setMyCommands(const String& commandArray) {
     if (sent) break;
   }
 
-  closeClient();
+  closeClient(pollConnection);
   return sent;
 }
 
 
+/***************************************************************
+ * SetBatchSize - number of updates one getUpdates call may    *
+ * return, from 1 up to HANDLE_MESSAGES                        *
+ ***************************************************************/
+void UniversalTelegramBot::setBatchSize(int size) {
+  batchSize = constrain(size, 1, HANDLE_MESSAGES);
+}
+
 /***************************************************************
  * GetUpdates - function to receive messages from telegram *
  * (Argument to pass: the last+1 message to read)             *
@@ -360,165 +558,182 @@ int UniversalTelegramBot::getUpdates(long offset) {
   String command = BOT_CMD("getUpdates?offset=");
   command += offset;
   command += F("&limit=");
-  command += HANDLE_MESSAGES;
+  command += batchSize;
 
   if (longPoll > 0) {
     command += F("&timeout=");
     command += String(longPoll);
   }
-  String response = sendGetToTelegram(command); // receive reply from telegram.org
 
-  if (response == "") {
+  // Only the fields processResult() reads are kept from the answer
+  static JsonDocument filter;
+  if (filter.isNull()) deserializeJson(filter, FPSTR(UPDATES_FILTER));
+
+  DynamicJsonDocument doc(maxMessageLength);
+  DeserializationError error = DeserializationError::EmptyInput;
+  bool answered = false;
+
+  // The body is parsed straight from the client. A kept-alive session may
+  // have been dropped by the server in the meantime, in that case retry once
+  // on a fresh connection
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = connectClient(pollConnection);
+    if (!pollConnection.client->connected()) break;
+
+    writeGetRequest(pollConnection, command);
+
+    TelegramAnswerReader reader(*pollConnection.client, longPoll * 1000 + waitForResponse, socketPollDelay);
+    pollConnection.reusable = false;
+    if (reader.readHeaders(nullptr)) {
+      answered = true;
+      error = deserializeJson(doc, reader, DeserializationOption::Filter(filter));
+      // leave the session clean for the next request
+      reader.drain();
+      pollConnection.reusable = reader.reusable();
+      break;
+    }
+    if (!reused) break;
+    pollConnection.client->stop();
+  }
+
+  if (!answered) {
     #ifdef TELEGRAM_DEBUG  
         Serial.println(F("Received empty string in response!"));
     #endif
-    // close the client as there's nothing to do with an empty string
-    closeClient();
+    // close the client as there's nothing to do with an empty answer
+    closeClient(pollConnection);
     return 0;
-  } else {
+  }
+
+  if (!error) {
     #ifdef TELEGRAM_DEBUG  
-      Serial.print(F("incoming message length "));
-      Serial.println(response.length());
-      Serial.println(F("Creating DynamicJsonBuffer"));
+      Serial.print(F("GetUpdates parsed jsonObj: "));
+      serializeJson(doc, Serial);
+      Serial.println();
     #endif
-
-    // Parse response into Json object
-    DynamicJsonDocument doc(maxMessageLength);
-    DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
-      
-    if (!error) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.print(F("GetUpdates parsed jsonObj: "));
-        serializeJson(doc, Serial);
-        Serial.println();
-      #endif
-      if (doc.containsKey("result")) {
-        int resultArrayLength = doc["result"].size();
-        if (resultArrayLength > 0) {
-          int newMessageIndex = 0;
-          // Step through all results
-          for (int i = 0; i < resultArrayLength; i++) {
-            JsonObject result = doc["result"][i];
-            if (processResult(result, newMessageIndex)) newMessageIndex++;
-          }
-          // We will keep the client open because there may be a response to be
-          // given
-          return newMessageIndex;
-        } else {
-          #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("no new messages"));
-          #endif
+    if (doc.containsKey("result")) {
+      int resultArrayLength = doc["result"].size();
+      if (resultArrayLength > 0) {
+        int newMessageIndex = 0;
+        // Step through all results
+        for (int i = 0; i < resultArrayLength && newMessageIndex < batchSize; i++) {
+          JsonObject result = doc["result"][i];
+          if (processResult(result, newMessageIndex)) newMessageIndex++;
         }
+        // We will keep the client open because there may be a response to be
+        // given
+        return newMessageIndex;
       } else {
         #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("Response contained no 'result'"));
-        #endif
-      }
-    } else { // Parsing failed
-      if (response.length() < 2) { // Too short a message. Maybe a connection issue
-        #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("Parsing error: Message too short"));
+          Serial.println(F("no new messages"));
         #endif
-      } else {
-        // Buffer may not be big enough, increase buffer or reduce max number of
-        // messages
-        #ifdef TELEGRAM_DEBUG 
-            Serial.print(F("Failed to parse update, the message could be too "
-                           "big for the buffer. Error code: "));
-            Serial.println(error.c_str()); // debug print of parsing error
-        #endif     
       }
+    } else {
+      #ifdef TELEGRAM_DEBUG  
+          Serial.println(F("Response contained no 'result'"));
+      #endif
     }
-    // Close the client as no response is to be given
-    closeClient();
-    return 0;
+  } else { // Parsing failed
+    // Buffer may not be big enough, increase buffer or reduce max number of
+    // messages
+    #ifdef TELEGRAM_DEBUG 
+        Serial.print(F("Failed to parse update, the message could be too "
+                       "big for the buffer. Error code: "));
+        Serial.println(error.c_str()); // debug print of parsing error
+    #endif     
   }
+  // Close the client as no response is to be given
+  closeClient(pollConnection);
+  return 0;
 }
 
 bool UniversalTelegramBot::processResult(JsonObject result, int messageIndex) {
   int update_id = result["update_id"];
   // Check have we already dealt with this message (this shouldn't happen!)
   if (last_message_received != update_id) {
+    // Fields are filled in place from the parsed document, nothing here
+    // allocates
+    telegramMessage &msg = messages[messageIndex];
     last_message_received = update_id;
-    messages[messageIndex].update_id = update_id;
-    messages[messageIndex].text = F("");
-    messages[messageIndex].from_id = F("");
-    messages[messageIndex].from_name = F("");
-    messages[messageIndex].longitude = 0;
-    messages[messageIndex].latitude = 0;
-    messages[messageIndex].reply_to_message_id = 0;
-    messages[messageIndex].reply_to_text = F("");
-    messages[messageIndex].query_id = F("");
+    msg.update_id = update_id;
+    msg.text = "";
+    msg.from_id = "";
+    msg.from_name = "";
+    msg.longitude = 0;
+    msg.latitude = 0;
+    msg.reply_to_message_id = 0;
+    msg.reply_to_text = "";
+    msg.query_id = "";
 
     if (result.containsKey("message")) {
       JsonObject message = result["message"];
-      messages[messageIndex].type = F("message");
-      messages[messageIndex].from_id = message["from"]["id"].as<String>();
-      messages[messageIndex].from_name = message["from"]["first_name"].as<String>();
-      messages[messageIndex].date = message["date"].as<String>();
-      messages[messageIndex].chat_id = message["chat"]["id"].as<String>();
-      messages[messageIndex].chat_title = message["chat"]["title"].as<String>();
-      messages[messageIndex].hasDocument = false;
-      messages[messageIndex].message_id = message["message_id"].as<int>();  // added message id
+      msg.type = "message";
+      msg.from_id.set(message["from"]["id"]);
+      msg.from_name.set(message["from"]["first_name"]);
+      msg.date.set(message["date"]);
+      msg.chat_id.set(message["chat"]["id"]);
+      msg.chat_title.set(message["chat"]["title"]);
+      msg.hasDocument = false;
+      msg.message_id = message["message_id"].as<int>();  // added message id
       if (message.containsKey("text")) {
-        messages[messageIndex].text = message["text"].as<String>();
+        msg.text.set(message["text"]);
           
       } else if (message.containsKey("location")) {
-        messages[messageIndex].longitude = message["location"]["longitude"].as<float>();
-        messages[messageIndex].latitude  = message["location"]["latitude"].as<float>();
+        msg.longitude = message["location"]["longitude"].as<float>();
+        msg.latitude  = message["location"]["latitude"].as<float>();
       } else if (message.containsKey("document")) {
-        String file_id = message["document"]["file_id"].as<String>();
-        messages[messageIndex].file_caption = message["caption"].as<String>();
-        messages[messageIndex].file_name = message["document"]["file_name"].as<String>();
-        if (getFile(messages[messageIndex].file_path, messages[messageIndex].file_size, file_id) == true)
-          messages[messageIndex].hasDocument = true;
+        const char *file_id = message["document"]["file_id"] | "";
+        msg.file_caption.set(message["caption"]);
+        msg.file_name.set(message["document"]["file_name"]);
+        if (getFile(msg.file_path.data(), msg.file_path.capacity(), msg.file_size, file_id) == true)
+          msg.hasDocument = true;
         else
-          messages[messageIndex].hasDocument = false;
+          msg.hasDocument = false;
       }
       if (message.containsKey("reply_to_message")) {
-        messages[messageIndex].reply_to_message_id = message["reply_to_message"]["message_id"];
-        // no need to check if containsKey["text"]. If it doesn't, it default to null
-        messages[messageIndex].reply_to_text = message["reply_to_message"]["text"].as<String>();
+        msg.reply_to_message_id = message["reply_to_message"]["message_id"];
+        // no need to check if containsKey["text"]. If it doesn't, it is left empty
+        msg.reply_to_text.set(message["reply_to_message"]["text"]);
       }
 
     } else if (result.containsKey("channel_post")) {
       JsonObject message = result["channel_post"];
-      messages[messageIndex].type = F("channel_post");
-      messages[messageIndex].text = message["text"].as<String>();
-      messages[messageIndex].date = message["date"].as<String>();
-      messages[messageIndex].chat_id = message["chat"]["id"].as<String>();
-      messages[messageIndex].chat_title = message["chat"]["title"].as<String>();
-      messages[messageIndex].message_id = message["message_id"].as<int>();  // added message id
+      msg.type = "channel_post";
+      msg.text.set(message["text"]);
+      msg.date.set(message["date"]);
+      msg.chat_id.set(message["chat"]["id"]);
+      msg.chat_title.set(message["chat"]["title"]);
+      msg.message_id = message["message_id"].as<int>();  // added message id
 
     } else if (result.containsKey("callback_query")) {
       JsonObject message = result["callback_query"];
-      messages[messageIndex].type = F("callback_query");
-      messages[messageIndex].from_id = message["from"]["id"].as<String>();
-      messages[messageIndex].from_name = message["from"]["first_name"].as<String>();
-      messages[messageIndex].text = message["data"].as<String>();
-      messages[messageIndex].date = message["date"].as<String>();
-      messages[messageIndex].chat_id = message["message"]["chat"]["id"].as<String>();
-      messages[messageIndex].reply_to_text = message["message"]["text"].as<String>();
-      messages[messageIndex].chat_title = F("");
-      messages[messageIndex].query_id = message["id"].as<String>();
-      messages[messageIndex].message_id = message["message"]["message_id"].as<int>();  // added message id
+      msg.type = "callback_query";
+      msg.from_id.set(message["from"]["id"]);
+      msg.from_name.set(message["from"]["first_name"]);
+      msg.text.set(message["data"]);
+      msg.date.set(message["date"]);
+      msg.chat_id.set(message["message"]["chat"]["id"]);
+      msg.reply_to_text.set(message["message"]["text"]);
+      msg.chat_title = "";
+      msg.query_id.set(message["id"]);
+      msg.message_id = message["message"]["message_id"].as<int>();  // added message id
 
     } else if (result.containsKey("edited_message")) {
       JsonObject message = result["edited_message"];
-      messages[messageIndex].type = F("edited_message");
-      messages[messageIndex].from_id = message["from"]["id"].as<String>();
-      messages[messageIndex].from_name = message["from"]["first_name"].as<String>();
-      messages[messageIndex].date = message["date"].as<String>();
-      messages[messageIndex].chat_id = message["chat"]["id"].as<String>();
-      messages[messageIndex].chat_title = message["chat"]["title"].as<String>();
-      messages[messageIndex].message_id = message["message_id"].as<int>();  // added message id
+      msg.type = "edited_message";
+      msg.from_id.set(message["from"]["id"]);
+      msg.from_name.set(message["from"]["first_name"]);
+      msg.date.set(message["date"]);
+      msg.chat_id.set(message["chat"]["id"]);
+      msg.chat_title.set(message["chat"]["title"]);
+      msg.message_id = message["message_id"].as<int>();  // added message id
 
       if (message.containsKey("text")) {
-        messages[messageIndex].text = message["text"].as<String>();
+        msg.text.set(message["text"]);
           
       } else if (message.containsKey("location")) {
-        messages[messageIndex].longitude = message["location"]["longitude"].as<float>();
-        messages[messageIndex].latitude  = message["location"]["latitude"].as<float>();
+        msg.longitude = message["location"]["longitude"].as<float>();
+        msg.latitude  = message["location"]["latitude"].as<float>();
       }
     }
     return true;
@@ -540,22 +755,22 @@ bool UniversalTelegramBot::sendSimpleMessage(const String& chat_id, const String
   unsigned long sttime = millis();
 
   if (text != "") {
-    while (millis() - sttime < 8000ul) { // loop for a while to send the message
+    do { // loop for a while to send the message
       String command = BOT_CMD("sendMessage?chat_id=");
       command += chat_id;
       command += F("&text=");
       command += text;
       command += F("&parse_mode=");
       command += parse_mode;
-      String response = sendGetToTelegram(command);
+      String response = sendGetToTelegram(*outgoing, command);
       #ifdef TELEGRAM_DEBUG  
         Serial.println(response);
       #endif
       sent = checkForOkResponse(response);
       if (sent) break;
-    }
+    } while (millis() - sttime < sendTimeout);
   }
-  closeClient();
+  closeClient(*outgoing);
   return sent;
 }
 
@@ -640,17 +855,17 @@ bool UniversalTelegramBot::sendPostMessage(JsonObject payload, bool edit) { // a
   unsigned long sttime = millis();
 
   if (payload.containsKey("text")) {
-    while (millis() < sttime + 8000) { // loop for a while to send the message
-        String response = sendPostToTelegram((edit ? BOT_CMD("editMessageText") : BOT_CMD("sendMessage")), payload); // if edit is true we send a editMessageText CMD
+    do { // loop for a while to send the message
+        String response = sendPostToTelegram(*outgoing, (edit ? BOT_CMD("editMessageText") : BOT_CMD("sendMessage")), payload); // if edit is true we send a editMessageText CMD
          #ifdef TELEGRAM_DEBUG  
         Serial.println(response);
       #endif
       sent = checkForOkResponse(response);
       if (sent) break;
-    }
+    } while (millis() - sttime < sendTimeout);
   }
 
-  closeClient();
+  closeClient(*outgoing);
   return sent;
 }
 
@@ -664,18 +879,18 @@ String UniversalTelegramBot::sendPostPhoto(JsonObject payload) {
   unsigned long sttime = millis();
 
   if (payload.containsKey("photo")) {
-    while (millis() - sttime < 8000ul) { // loop for a while to send the message
-      response = sendPostToTelegram(BOT_CMD("sendPhoto"), payload);
+    do { // loop for a while to send the message
+      response = sendPostToTelegram(*outgoing, BOT_CMD("sendPhoto"), payload);
       #ifdef TELEGRAM_DEBUG  
         Serial.println(response);
       #endif
       sent = checkForOkResponse(response);
       if (sent) break;
       
-    }
+    } while (millis() - sttime < sendTimeout);
   }
 
-  closeClient();
+  closeClient(*outgoing);
   return response;
 }
 
@@ -747,13 +962,13 @@ bool UniversalTelegramBot::sendChatAction(const String& chat_id, const String& t
   unsigned long sttime = millis();
 
   if (text != "") {
-    while (millis() - sttime < 8000ul) { // loop for a while to send the message
+    do { // loop for a while to send the message
       String command = BOT_CMD("sendChatAction?chat_id=");
       command += chat_id;
       command += F("&action=");
       command += text;
 
-      String response = sendGetToTelegram(command);
+      String response = sendGetToTelegram(*outgoing, command);
 
       #ifdef TELEGRAM_DEBUG  
         Serial.println(response);
@@ -762,35 +977,37 @@ bool UniversalTelegramBot::sendChatAction(const String& chat_id, const String& t
 
       if (sent) break;
       
-    }
+    } while (millis() - sttime < sendTimeout);
   }
 
-  closeClient();
+  closeClient(*outgoing);
   return sent;
 }
 
-void UniversalTelegramBot::closeClient() {
-  if (client->connected()) {
+// Ends an exchange. The session is kept when keepAlive is set and the
+// last answer was read completely.
+void UniversalTelegramBot::closeClient(TelegramConnection &conn) {
+  if (conn.client->connected() && !(keepAlive && conn.reusable)) {
     #ifdef TELEGRAM_DEBUG  
         Serial.println(F("Closing client"));
     #endif
-    client->stop();
+    conn.client->stop();
   }
 }
 
-bool UniversalTelegramBot::getFile(String& file_path, long& file_size, const String& file_id)
+bool UniversalTelegramBot::getFile(char *file_path, size_t size, long& file_size, const char *file_id)
 {
   String command = BOT_CMD("getFile?file_id=");
   command += file_id;
   String response = sendGetToTelegram(command); // receive reply from telegram.org
   DynamicJsonDocument doc(maxMessageLength);
   DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
-  closeClient();
+  closeClient(pollConnection);
 
   if (!error) {
     if (doc.containsKey("result")) {
-      file_path  = F("https://api.telegram.org/file/");
-      file_path += buildCommand(doc["result"]["file_path"]);
+      snprintf(file_path, size, "https://api.telegram.org/file/bot%s/%s",
+               _token.c_str(), doc["result"]["file_path"] | "");
       file_size = doc["result"]["file_size"].as<long>();
       return true;
     }
@@ -808,12 +1025,12 @@ bool UniversalTelegramBot::answerCallbackQuery(const String &query_id, const Str
   if (text.length() > 0) payload["text"] = text;
   if (url.length() > 0) payload["url"] = url;
 
-  String response = sendPostToTelegram(BOT_CMD("answerCallbackQuery"), payload.as<JsonObject>());
+  String response = sendPostToTelegram(*outgoing, BOT_CMD("answerCallbackQuery"), payload.as<JsonObject>());
   #ifdef _debug  
      Serial.print(F("answerCallbackQuery response:"));
      Serial.println(response);
   #endif
   bool answer = checkForOkResponse(response);
-  closeClient();
+  closeClient(*outgoing);
   return answer;
 }
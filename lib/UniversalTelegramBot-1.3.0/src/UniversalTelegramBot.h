@@ -32,7 +32,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #define TELEGRAM_HOST "api.telegram.org"
 #define TELEGRAM_SSL_PORT 443
+// Room for updates fetched by one getUpdates(), set it from the build flags
+// (-DHANDLE_MESSAGES=8) to handle bursts in fewer requests
+#ifndef HANDLE_MESSAGES
 #define HANDLE_MESSAGES 1
+#endif
 
 //unmark following line to enable debug mode
 //#define _debug
@@ -42,17 +46,77 @@ typedef byte (*GetNextByte)();
 typedef byte* (*GetNextBuffer)();
 typedef int (GetNextBufferLen)();
 
+// Capacity of the text fields of a message, longer values are truncated
+// and flagged, see TelegramField::truncated()
+#ifndef TELEGRAM_TEXT_SIZE
+#define TELEGRAM_TEXT_SIZE 256
+#endif
+#ifndef TELEGRAM_NAME_SIZE
+#define TELEGRAM_NAME_SIZE 64
+#endif
+#define TELEGRAM_ID_SIZE 24
+#define TELEGRAM_PATH_SIZE 192
+
+// A string stored inline in a fixed buffer. Filling it never touches the
+// heap; it converts to String where the String API is needed.
+template <size_t N>
+class TelegramField {
+public:
+  TelegramField() { buffer[0] = '\0'; cut = false; }
+
+  TelegramField &operator=(const char *value) { assign(value, value ? strlen(value) : 0); return *this; }
+  TelegramField &operator=(const String &value) { assign(value.c_str(), value.length()); return *this; }
+  TelegramField &operator=(const __FlashStringHelper *value) { return *this = String(value); }
+
+  // Strings are copied, other values take their JSON form, null is empty
+  void set(JsonVariantConst value) {
+    if (value.is<const char *>()) *this = value.as<const char *>();
+    else if (value.isNull()) { buffer[0] = '\0'; cut = false; }
+    else { cut = measureJson(value) > N - 1; serializeJson(value, buffer, N); }
+  }
+
+  // Cut at n bytes, backing off to a UTF-8 character boundary
+  void assign(const char *value, size_t n) {
+    cut = n > N - 1;
+    if (cut) {
+      n = N - 1;
+      while (n > 0 && (value[n] & 0xC0) == 0x80) n--;
+    }
+    memcpy(buffer, value, n);
+    buffer[n] = '\0';
+  }
+
+  operator String() const { return String(buffer); }
+  const char *c_str() const { return buffer; }
+  char *data() { return buffer; }
+  size_t capacity() const { return N; }
+  // The value didn't fit and was cut: a command cut short must not run
+  bool truncated() const { return cut; }
+  unsigned int length() const { return strlen(buffer); }
+  float toFloat() const { return atof(buffer); }
+  long toInt() const { return atol(buffer); }
+
+  bool operator==(const char *other) const { return strcmp(buffer, other) == 0; }
+  bool operator==(const String &other) const { return other == buffer; }
+  bool operator!=(const char *other) const { return !(*this == other); }
+  bool operator!=(const String &other) const { return !(*this == other); }
+
+private:
+  char buffer[N];
+  bool cut;
+};
+
 struct telegramMessage {
-  String text;
-  String chat_id;
-  String chat_title;
-  String from_id;
-  String from_name;
-  String date;
-  String type;
-  String file_caption;
-  String file_path;
-  String file_name;
+  TelegramField<TELEGRAM_TEXT_SIZE> text;
+  TelegramField<TELEGRAM_ID_SIZE> chat_id;
+  TelegramField<TELEGRAM_NAME_SIZE> chat_title;
+  TelegramField<TELEGRAM_ID_SIZE> from_id;
+  TelegramField<TELEGRAM_NAME_SIZE> from_name;
+  TelegramField<TELEGRAM_ID_SIZE> date;
+  TelegramField<16> type;
+  TelegramField<TELEGRAM_TEXT_SIZE> file_caption;
+  TelegramField<TELEGRAM_PATH_SIZE> file_path;
+  TelegramField<TELEGRAM_NAME_SIZE> file_name;
   bool hasDocument;
   long file_size;
   float longitude;
@@ -61,13 +125,20 @@ struct telegramMessage {
   int message_id;  
 
   int reply_to_message_id;
-  String reply_to_text;
-  String query_id;
+  TelegramField<TELEGRAM_TEXT_SIZE> reply_to_text;
+  TelegramField<TELEGRAM_NAME_SIZE> query_id;
+};
+
+// A client and whether its session can serve another request
+struct TelegramConnection {
+  Client *client;
+  bool reusable;
 };
 
 class UniversalTelegramBot {
 public:
   UniversalTelegramBot(const String& token, Client &client);
+  void setSendClient(Client &client);
   void updateToken(const String& token);
   String getToken();
   String sendGetToTelegram(const String& command);
@@ -117,6 +188,7 @@ public:
   String buildCommand(const String& cmd);
 
   int getUpdates(long offset);
+  void setBatchSize(int size);
   bool checkForOkResponse(const String& response);
   telegramMessage messages[HANDLE_MESSAGES];
   long last_message_received;
@@ -124,6 +196,9 @@ public:
   String userName;
   int longPoll = 0;
   unsigned int waitForResponse = 1500;
+  unsigned int socketPollDelay = 10; // ms slept between reads while waiting for the answer
+  bool keepAlive = true; // keep the TLS session open between requests
+  unsigned long sendTimeout = 8000; // ms a message is retried for, 0 tries once
   int _lastError;
   int last_sent_message_id = 0;
   int maxMessageLength = 1500;
@@ -132,8 +207,17 @@ private:
   // JsonObject * parseUpdates(String response);
   String _token;
   Client *client;
-  void closeClient();
-  bool getFile(String& file_path, long& file_size, const String& file_id);
+  int batchSize = HANDLE_MESSAGES;    // updates requested per getUpdates
+  TelegramConnection pollConnection;  // getUpdates and other queries
+  TelegramConnection sendConnection;  // outgoing messages when setSendClient() was called
+  TelegramConnection *outgoing;       // &sendConnection or &pollConnection
+  bool connectClient(TelegramConnection &conn);
+  void writeGetRequest(TelegramConnection &conn, const String& command);
+  String sendGetToTelegram(TelegramConnection &conn, const String& command);
+  String sendPostToTelegram(TelegramConnection &conn, const String& command, JsonObject payload);
+  bool readHTTPAnswer(TelegramConnection &conn, String &body, String &headers);
+  void closeClient(TelegramConnection &conn);
+  bool getFile(char *file_path, size_t size, long& file_size, const char *file_id);
   bool processResult(JsonObject result, int messageIndex);
 };
 
@@ -0,0 +1,70 @@
+#include "botSender.h"
+
+typedef struct {
+  char chat_id[TELEGRAM_ID_SIZE];
+  char parse_mode[12];
+  char text[BOT_REPLY_SIZE];
+} botReply_t;
+
+static QueueHandle_t         replyQueue = NULL;
+static UniversalTelegramBot* sender     = NULL;
+
+void botSenderBegin(UniversalTelegramBot* bot)
+{
+  sender = bot;
+  /* one attempt per call, retries are paced by vBotSenderTask */
+  sender->sendTimeout = 0;
+  replyQueue = xQueueCreate(BOT_SEND_QUEUE, sizeof(botReply_t));
+}
+
+bool queueReply(const char* chat_id, const char* text, const char* parse_mode)
+{
+  static botReply_t reply;  /* only the message task queues replies */
+
+  if (replyQueue == NULL) return false;
+  strlcpy(reply.chat_id, chat_id, sizeof(reply.chat_id));
+  strlcpy(reply.parse_mode, parse_mode, sizeof(reply.parse_mode));
+  if (strlcpy(reply.text, text, sizeof(reply.text)) >= sizeof(reply.text))
+  {
+    /* back off to a character: Telegram refuses a message with a UTF-8
+     * sequence cut in half */
+    size_t n = sizeof(reply.text) - 1;
+    while (n > 0 && (text[n] & 0xC0) == 0x80) n--;
+    reply.text[n] = '\0';
+    Serial.printf("reply of %u bytes cut to BOT_REPLY_SIZE\n", (unsigned)strlen(text));
+  }
+
+  if (xQueueSend(replyQueue, &reply, 0) != pdTRUE)
+  {
+    Serial.println("reply queue full, reply dropped");
+    return false;
+  }
+  return true;
+}
+
+void vBotSenderTask(void *px)
+{
+  static botReply_t reply;
+  TickType_t backoff;
+
+  while(1)
+  {
+    if (xQueueReceive(replyQueue, &reply, portMAX_DELAY) != pdTRUE) continue;
+
+    backoff = pdMS_TO_TICKS(BOT_SEND_BACKOFF);
+    for (int attempt = 1; ; attempt++)
+    {
+      if (sender->sendMessage(reply.chat_id, reply.text, reply.parse_mode)) break;
+      if (attempt == BOT_SEND_RETRIES)
+      {
+        Serial.println("reply not sent, dropped");
+        break;
+      }
+      vTaskDelay(backoff);
+      backoff *= 2;
+    }
+  }
+
+  /* Must not exit, but if you leave the while(1) you can delete the task */
+  vTaskDelete(NULL);
+}
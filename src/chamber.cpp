@@ -0,0 +1,55 @@
+#include "chamber.h"
+#include "tempHistory.h"
+
+static float loadSetpoint(chamber_t* c, const char* key, float fallback)
+{
+  float value = c->pref.getFloat(key, fallback);
+
+  if (!isfinite(value) || value < SETPOINT_MIN || value > SETPOINT_MAX) return fallback;
+  return value;
+}
+
+void chamberBegin(chamber_t* c, uint8_t index)
+{
+  char ns[8];
+
+  pinMode(c->fanPin,  OUTPUT);
+  pinMode(c->heatPin, OUTPUT);
+  pinMode(c->coolPin, OUTPUT);
+  digitalWrite(c->fanPin,  LOW);
+  digitalWrite(c->heatPin, LOW);
+  digitalWrite(c->coolPin, LOW);
+  c->driven = 0;
+  c->state.currentMode = UNDEFINED;
+
+  if (index == 0) strlcpy(ns, "temp", sizeof(ns));
+  else snprintf(ns, sizeof(ns), "temp%u", index + 1);
+  c->pref.begin(ns, false);
+  c->settings.tempH  = loadSetpoint(c, "tempH",  22.0);
+  c->settings.tempHH = loadSetpoint(c, "tempHH", 23.0);
+  c->settings.tempL  = loadSetpoint(c, "tempL",  18.0);
+  c->settings.tempLL = loadSetpoint(c, "tempLL", 17.0);
+  c->settings.selectedMode = c->pref.getULong("selMode", COOLING);
+}
+
+uint8_t chamberRelays(const chamber_t* c)
+{
+  return (c->state.blowing ? HIST_FAN  : 0) |
+         (c->state.cooling ? HIST_COOL : 0) |
+         (c->state.heating ? HIST_HEAT : 0);
+}
+
+void chamberDriveRelays(chamber_t* c)
+{
+  uint8_t want = chamberRelays(c);
+  uint8_t off  = c->driven & ~want;
+  uint8_t on   = want & ~c->driven;
+
+  if (off & HIST_COOL) digitalWrite(c->coolPin, LOW);
+  if (off & HIST_HEAT) digitalWrite(c->heatPin, LOW);
+  if (off & HIST_FAN)  digitalWrite(c->fanPin,  LOW);
+  if (on & HIST_FAN)   digitalWrite(c->fanPin,  HIGH);
+  if (on & HIST_COOL)  digitalWrite(c->coolPin, HIGH);
+  if (on & HIST_HEAT)  digitalWrite(c->heatPin, HIGH);
+  c->driven = want;
+}
@@ -0,0 +1,264 @@
+#include "fermentLog.h"
+
+/* Record layout, little endian:
+ *   'F' 'L' count reserved    4 bytes
+ *   first minute              4 bytes
+ *   first value per probe     2 bytes each, centi degrees
+ *   count entries             1 delta byte per probe + flags byte
+ *   CRC-16/CCITT of the above 2 bytes
+ * Deltas are taken from the rebuilt value, as in tempHistory.
+ */
+#define FLOG_HEAD   (8 + 2 * SAMPLE_PROBES)
+#define FLOG_ENTRY  (SAMPLE_PROBES + 1)
+#define FLOG_RECORD (FLOG_HEAD + FLOG_BATCH * FLOG_ENTRY + 2)
+#define FLOG_NAME   (sizeof(FLOG_DIR) + 14)
+#define FLOG_CLOCK  (1600000000)  /* time() is set once past this */
+
+static fs::FS*  logFs = NULL;
+static uint32_t segSeq;           /* sequence number of the open segment */
+static uint32_t segSize;          /* bytes in the open segment */
+static uint32_t lastMinute = 0;
+
+static uint8_t  record[FLOG_RECORD];
+static uint8_t  count = 0;        /* entries in record */
+static int16_t  current[SAMPLE_PROBES];
+
+static uint16_t crc16(const uint8_t* data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static void segName(char* name, uint32_t seq)
+{
+  snprintf(name, FLOG_NAME, FLOG_DIR "/%08lx.seg", (unsigned long)seq);
+}
+
+/* oldest and newest segment sequence numbers, returns the segment count */
+static uint8_t listSegments(uint32_t* oldest, uint32_t* newest)
+{
+  File     dir = logFs->open(FLOG_DIR);
+  File     f;
+  uint8_t  n = 0;
+  uint32_t seq;
+  char*    end;
+
+  if (!dir) return 0;
+  while ((f = dir.openNextFile()))
+  {
+    const char* name = strrchr(f.name(), '/');
+    name = name ? name + 1 : f.name();
+    seq = strtoul(name, &end, 16);
+    /* name points into f, done with it before closing */
+    if (end == name || strcmp(end, ".seg") != 0)
+    {
+      f.close();
+      continue;
+    }
+    f.close();
+    if (n == 0 || seq < *oldest) *oldest = seq;
+    if (n == 0 || seq > *newest) *newest = seq;
+    n++;
+  }
+  dir.close();
+  return n;
+}
+
+/* Read the record at the file position, false at the end or on damage */
+static bool readRecord(File& f, uint8_t* buf, uint8_t* n)
+{
+  uint16_t len, crc;
+
+  if (f.read(buf, FLOG_HEAD) != FLOG_HEAD) return false;
+  if (buf[0] != 'F' || buf[1] != 'L' || buf[2] == 0 || buf[2] > FLOG_BATCH) return false;
+  *n  = buf[2];
+  len = FLOG_HEAD + *n * FLOG_ENTRY;
+  if (f.read(buf + FLOG_HEAD, len - FLOG_HEAD + 2) != (size_t)(len - FLOG_HEAD + 2)) return false;
+  crc = buf[len] | (uint16_t)buf[len + 1] << 8;
+  return crc == crc16(buf, len);
+}
+
+/* Start segment seq, dropping the oldest ones beyond FLOG_SEGMENTS */
+static void openSegment(uint32_t seq)
+{
+  char     name[FLOG_NAME];
+  uint32_t oldest, newest;
+
+  while (listSegments(&oldest, &newest) >= FLOG_SEGMENTS)
+  {
+    segName(name, oldest);
+    if (!logFs->remove(name)) break;
+  }
+  segSeq  = seq;
+  segSize = 0;
+}
+
+bool fermentLogBegin(fs::FS& fs)
+{
+  char     name[FLOG_NAME];
+  uint32_t oldest, newest, minute;
+  uint8_t  n;
+  File     f;
+
+  logFs = &fs;
+  if (!fs.exists(FLOG_DIR) && !fs.mkdir(FLOG_DIR))
+  {
+    logFs = NULL;
+    return false;
+  }
+
+  if (listSegments(&oldest, &newest) == 0)
+  {
+    openSegment(0);
+    return true;
+  }
+
+  /* find the end of the newest segment */
+  segName(name, newest);
+  f = fs.open(name, "r");
+  segSeq  = newest;
+  segSize = 0;
+  while (f && readRecord(f, record, &n))
+  {
+    memcpy(&minute, record + 4, 4);
+    lastMinute = minute + n - 1;
+    segSize += FLOG_HEAD + n * FLOG_ENTRY + 2;
+  }
+  /* a damaged tail stays where it is, new records go to a new segment */
+  if (f && segSize != f.size()) openSegment(newest + 1);
+  if (f) f.close();
+  return true;
+}
+
+void fermentLogFlush(void)
+{
+  char     name[FLOG_NAME];
+  uint16_t len, crc;
+  File     f;
+
+  if (count == 0 || logFs == NULL) return;
+
+  record[0] = 'F';
+  record[1] = 'L';
+  record[2] = count;
+  record[3] = 0;
+  len = FLOG_HEAD + count * FLOG_ENTRY;
+  crc = crc16(record, len);
+  record[len]     = crc & 0xFF;
+  record[len + 1] = crc >> 8;
+  len += 2;
+
+  if (segSize + len > FLOG_SEG_SIZE) openSegment(segSeq + 1);
+  segName(name, segSeq);
+  f = logFs->open(name, "a");
+  if (f)
+  {
+    if (f.write(record, len) == len) segSize += len;
+    f.close();
+  }
+  count = 0;
+}
+
+void fermentLogAppend(uint32_t minute, const historyPoint_t* point)
+{
+  uint8_t* e;
+  int32_t  d;
+  int16_t  temp;
+
+  if (logFs == NULL || minute <= lastMinute) return;
+  if (count > 0 && minute != lastMinute + 1) fermentLogFlush();
+
+  if (count == 0)
+  {
+    memcpy(record + 4, &minute, 4);
+    for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+    {
+      current[p] = lroundf(point->temp[p] * 100);
+      memcpy(record + 8 + 2 * p, &current[p], 2);
+    }
+  }
+
+  e = record + FLOG_HEAD + count * FLOG_ENTRY;
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+  {
+    temp = lroundf(point->temp[p] * 100);
+    d = (point->flags & HIST_INVALID(p)) ? 0 : temp - current[p];
+    d = constrain(d, -128, 127);
+    e[p] = (int8_t)d;
+    current[p] += d;
+  }
+  e[SAMPLE_PROBES] = point->flags;
+
+  lastMinute = minute;
+  if (++count == FLOG_BATCH) fermentLogFlush();
+}
+
+void fermentLogSink(const historyPoint_t* point, unsigned long stamp, void* /* arg */)
+{
+  static uint32_t next = 0;  /* minute of the next entry, 0 until the clock is set */
+  time_t   now = time(nullptr);
+  uint32_t minute;
+
+  if (now < FLOG_CLOCK) return;
+  /* entries of missed periods come late, in a burst */
+  minute = (now - (millis() - stamp) / 1000) / 60;
+  if (next == 0 || next + FLOG_DRIFT < minute || next > minute + FLOG_DRIFT) next = minute;
+  /* a reset within the minute of the last entry logged */
+  if (next <= lastMinute) next = lastMinute + 1;
+  fermentLogAppend(next++, point);
+}
+
+uint32_t fermentLogLastMinute(void)
+{
+  return lastMinute;
+}
+
+uint32_t fermentLogReplay(uint32_t fromMinute, flogVisitor_t visit, void* arg)
+{
+  static uint8_t buf[FLOG_RECORD];  /* the caller's stack is small */
+  char           name[FLOG_NAME];
+  historyPoint_t point;
+  int16_t        temp[SAMPLE_PROBES];
+  uint32_t       oldest, newest, minute, visited = 0;
+  uint8_t        n;
+  File           f;
+
+  if (logFs == NULL || listSegments(&oldest, &newest) == 0) return 0;
+
+  for (uint32_t seq = oldest; seq <= newest; seq++)
+  {
+    segName(name, seq);
+    f = logFs->open(name, "r");
+    if (!f) continue;
+    while (readRecord(f, buf, &n))
+    {
+      memcpy(&minute, buf + 4, 4);
+      if (minute + n <= fromMinute) continue;
+      memcpy(temp, buf + 8, sizeof(temp));
+      for (uint8_t i = 0; i < n; i++, minute++)
+      {
+        const uint8_t* e = buf + FLOG_HEAD + i * FLOG_ENTRY;
+        for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+        {
+          temp[p] += (int8_t)e[p];
+          point.temp[p] = temp[p] / 100.0;
+        }
+        point.flags = e[SAMPLE_PROBES];
+        if (minute < fromMinute) continue;
+        visit(minute, &point, arg);
+        visited++;
+      }
+    }
+    f.close();
+  }
+  return visited;
+}
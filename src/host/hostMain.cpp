@@ -0,0 +1,336 @@
+/* Runs the firmware itself, main.cpp and every task it starts, on the
+ * host under the virtual clock of lib/HostShim. Every chamber of the
+ * table gets its own thermal plant of src/sim, read through simulated
+ * DS18B20 on OneWireSim and driven back by the chamber's relays. A
+ * script and then a seeded stream of Telegram commands exercise the bot
+ * while the relay outputs are checked:
+ *   - cooling and heating never on together
+ *   - the compressor rests COOL_WAIT before starting again
+ *   - every command that answers does so within HOST_REPLY_LIMIT
+ * At HOST_SWAP_AT the liquid probe of the last chamber is unplugged and
+ * a spare plugged in its place, the probe scan must hand it the role.
+ *
+ *   host [hours] [seed] [-v]
+ *
+ * stdout depends only on hours and seed, two runs can be diffed; the
+ * wall time goes to stderr. Exits 1 when an invariant broke.
+ *
+ * Build it with "pio run -e host", or by hand from the project root:
+ *   g++ -std=gnu++17 -O2 -pthread -DARDUINO=10819 -DONEWIRE_BACKEND=1 \
+ *       -Iinclude -Ilib/HostShim/src -Ilib/OneWire-2.3.8 \
+ *       -Ilib/DallasTemperature-3.9.0 -Ilib/ArduinoJson-7.2.0/src \
+ *       -Ilib/UniversalTelegramBot-1.3.0/src src/host/hostMain.cpp \
+ *       src/sim/thermalPlant.cpp src/[a-z]*.cpp lib/HostShim/src/[a-zA-Z]*.cpp \
+ *       lib/OneWire-2.3.8/[a-zA-Z]*.cpp lib/DallasTemperature-3.9.0/DallasTemperature.cpp \
+ *       lib/UniversalTelegramBot-1.3.0/src/UniversalTelegramBot.cpp -o host
+ *
+ * The unit tests under test/ build on the same env with their own main(),
+ * this runner is left out of them.
+ */
+#ifndef PIO_UNIT_TESTING
+#include <Arduino.h>
+#include <OneWireSim.h>
+#include <chrono>
+#include <deque>
+#include "hostShim.h"
+#include "chamber.h"
+#include "../sim/thermalPlant.h"
+
+#define HOST_HOURS       (48)
+#define HOST_STEP        (1000)    /* ms between plant steps */
+#define HOST_CHAT_ID     "1000"
+#define HOST_REPLY_LIMIT (30000)   /* ms from a command to its answer */
+#define HOST_FUZZ_MIN    (60)      /* s between fuzzed commands */
+#define HOST_FUZZ_MAX    (3600)
+#define HOST_SWAP_AT     (6 * 3600)  /* s */
+#define HOST_SWAP_GAP    (600)       /* s without a liquid probe */
+#define HOST_SPARE       (0x99)      /* serial of the spare probe */
+
+void setup();
+extern OneWire oneWire;
+
+typedef struct {
+  uint32_t    at;       /* s after boot */
+  const char *text;
+  bool        replies;  /* the bot answers it */
+} hostCommand_t;
+
+static const hostCommand_t script[] = {
+  { 10,    "/start",          true  },
+  { 60,    "/status",         true  },
+  { 61,    "/getTemp",        true  },
+  { 120,   "/setModeAuto",    false },
+  { 180,   "/chamber 2",      true  },
+  { 181,   "/setModePid",     false },
+  { 182,   "/chamber 1",      true  },
+  { 3600,  "/setTempH 21",    true  },
+  { 3601,  "/setTempHp",      true  },
+  { 3602,  "/setTempL",       true  },
+  { 7200,  "/history",        true  },
+  { 21600, "/setModePid",     false },
+  { 43200, "/stats",          true  },
+  { 43201, "/status",         true  },
+};
+#define NUM_SCRIPT (sizeof(script) / sizeof(script[0]))
+
+/* what the fuzzer picks from, bad input included */
+static const hostCommand_t fuzzPool[] = {
+  { 0, "/status",          true  },
+  { 0, "/getTemp",         true  },
+  { 0, "/getChamberTemp",  true  },
+  { 0, "/getLiquidTemp",   true  },
+  { 0, "/history",         true  },
+  { 0, "/history 3",       true  },
+  { 0, "/stats",           true  },
+  { 0, "/start",           true  },
+  { 0, "/setModeAuto",     false },
+  { 0, "/setModeCool",     false },
+  { 0, "/setModeHeat",     false },
+  { 0, "/setModePid",      false },
+  { 0, "/setModeOff",      false },
+  { 0, "/setTempH 23.5",   true  },
+  { 0, "/setTempHH 25",    true  },
+  { 0, "/setTempL 17",     true  },
+  { 0, "/setTempLL 15",    true  },
+  { 0, "/setTempHp",       true  },
+  { 0, "/setTempHm",       true  },
+  { 0, "/setTempLp",       true  },
+  { 0, "/setTempLm",       true  },
+  { 0, "/setTempH abc",    true  },
+  { 0, "/setTempHH nan",   true  },
+  { 0, "/setTempL",        true  },
+  { 0, "/status@host_bot", true  },
+  { 0, "/chamber",         true  },
+  { 0, "/chamber 1",       true  },
+  { 0, "/chamber 2",       true  },
+  { 0, "/chamber 9",       true  },
+  { 0, "/probes",          true  },
+  { 0, "/setProbe 9 l",    true  },
+  { 0, "/setProbe 1 x",    true  },
+  { 0, "/nope",            false },
+  { 0, "hola",             false },
+};
+#define NUM_FUZZ (sizeof(fuzzPool) / sizeof(fuzzPool[0]))
+
+/* a simulated chamber */
+typedef struct {
+  plantState_t plant;
+  int          probe[SAMPLE_PROBES];  /* device index on the bus */
+  bool         level[PLANT_RELAYS];
+  uint32_t     toggles[PLANT_RELAYS];
+  uint32_t     coolStopped;           /* ms */
+  bool         coolEverOn;
+} hostChamber_t;
+
+typedef struct {
+  std::deque<uint32_t> pending;   /* ms each awaited answer was asked at */
+  uint32_t sent, replies, unsolicited, late, maxLatency;
+  uint64_t digest;                /* FNV-1a over every answer */
+} replyTrack_t;
+
+static OneWireSim    bus;
+static hostChamber_t sim[SAMPLE_CHANNELS];
+static replyTrack_t  answers;
+static uint32_t      violations = 0;
+static bool          verbose = false;
+static uint32_t      fuzzSeed;
+
+static uint32_t busClock(void)
+{
+  return (uint32_t)hostMicros();
+}
+
+static uint32_t fuzzNext(void)
+{
+  fuzzSeed = fuzzSeed * 1664525 + 1013904223;
+  return fuzzSeed >> 8;
+}
+
+static void violation(uint8_t chamber, const char *what)
+{
+  violations++;
+  printf("%10.1f s  VIOLATION chamber %u: %s\n", millis() / 1000.0, chamber + 1, what);
+}
+
+static void onPinWrite(uint8_t pin, uint8_t level, void * /* arg */)
+{
+  hostChamber_t *h;
+  int relay = -1;
+  uint8_t c;
+
+  for (c = 0; c < numChambers && relay < 0; c++)
+  {
+    relay = pin == chambers[c].fanPin  ? PLANT_FAN  :
+            pin == chambers[c].coolPin ? PLANT_COOL :
+            pin == chambers[c].heatPin ? PLANT_HEAT : -1;
+  }
+  if (relay < 0) return;
+  c--;
+  h = &sim[c];
+  if (h->level[relay] == (level == HIGH)) return;
+  h->level[relay] = level == HIGH;
+  h->toggles[relay]++;
+  if (relay == PLANT_COOL && level == HIGH)
+  {
+    if (h->coolEverOn && millis() - h->coolStopped < COOL_WAIT)
+      violation(c, "compressor restarted before COOL_WAIT");
+    h->coolEverOn = true;
+  }
+  if (relay == PLANT_COOL && level == LOW) h->coolStopped = millis();
+  if (h->level[PLANT_COOL] && h->level[PLANT_HEAT]) violation(c, "cooling and heating together");
+  if (verbose) printf("%10.1f s  pin %u %s\n", millis() / 1000.0, pin, level ? "HIGH" : "LOW");
+}
+
+static void onReply(const char *chat_id, const char *text, void * /* arg */)
+{
+  uint32_t latency;
+
+  for (const char *c = text; *c; c++) answers.digest = (answers.digest ^ (uint8_t)*c) * 1099511628211ULL;
+  answers.replies++;
+  if (verbose) printf("%10.1f s  reply to %s: %s\n", millis() / 1000.0, chat_id, text);
+  if (answers.pending.empty())
+  {
+    answers.unsolicited++;
+    return;
+  }
+  latency = millis() - answers.pending.front();
+  answers.pending.pop_front();
+  if (latency > answers.maxLatency) answers.maxLatency = latency;
+  if (latency > HOST_REPLY_LIMIT) answers.late++;
+}
+
+static void send(const hostCommand_t *cmd)
+{
+  if (verbose) printf("%10.1f s  send %s\n", millis() / 1000.0, cmd->text);
+  hostTelegramMessage(HOST_CHAT_ID, "host", cmd->text);
+  answers.sent++;
+  if (cmd->replies) answers.pending.push_back(millis());
+}
+
+/* a simulated probe answering at the address of the chamber table */
+static int addProbe(const uint8_t *addr)
+{
+  uint64_t serial = 0;
+  int idx;
+
+  for (int i = 6; i >= 1; i--) serial = serial << 8 | addr[i];
+  idx = bus.addDevice(addr[0], serial);
+  if (memcmp(bus.rom(idx), addr, 8) != 0)
+  {
+    printf("probe address has a bad CRC, the firmware will not find it\n");
+  }
+  return idx;
+}
+
+/* the plants follow the relays for one step, the probes the plants */
+static void stepPlants(const plantParams_t *params)
+{
+  hostChamber_t *h;
+  uint8_t on;
+
+  for (uint8_t c = 0; c < numChambers; c++)
+  {
+    h  = &sim[c];
+    on = 0;
+    for (int r = 0; r < PLANT_RELAYS; r++) on |= h->level[r] << r;
+    plantStep(&h->plant, params, on, millis() / 1000.0, HOST_STEP / 1000.0f);
+    bus.setTemperature(h->probe[PROBE_CHAMBER], h->plant.air);
+    bus.setTemperature(h->probe[PROBE_LIQUID], h->plant.liquid);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  plantParams_t params;
+  uint32_t hours = HOST_HOURS, seed = 1, steps, nextScript = 0, nextFuzz;
+  int argn = 0, spare, swapped;
+  hostChamber_t *last;
+  std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+  double wall;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) verbose = true;
+    else if (argn++ == 0) hours = atoi(argv[i]);
+    else seed = atoi(argv[i]);
+  }
+  if (hours == 0) hours = HOST_HOURS;
+  fuzzSeed = seed;
+
+  hostBegin();
+  hostSerialEcho(verbose);
+  hostOnPinWrite(onPinWrite, nullptr);
+  hostOnTelegramReply(onReply, nullptr);
+
+  plantDefaults(&params);
+  bus.setClock(busClock);
+  for (uint8_t c = 0; c < numChambers; c++)
+  {
+    /* the chambers start apart so their relays don't move in step */
+    plantInit(&sim[c].plant, params.roomMean - 4 * c);
+    for (int p = 0; p < SAMPLE_PROBES; p++) sim[c].probe[p] = addProbe(chambers[c].probe[p]);
+  }
+  last    = &sim[numChambers - 1];
+  spare   = bus.addDevice(0x28, HOST_SPARE);
+  swapped = last->probe[PROBE_LIQUID];
+  bus.setConnected(spare, false);
+  stepPlants(&params);
+  oneWire.begin(&bus);
+
+  setup();
+
+  nextFuzz = script[NUM_SCRIPT - 1].at + HOST_FUZZ_MIN;
+  steps = hours * 3600000UL / HOST_STEP;
+  for (uint32_t s = 0; s < steps; s++)
+  {
+    uint32_t now = millis() / 1000;
+
+    while (nextScript < NUM_SCRIPT && script[nextScript].at <= now) send(&script[nextScript++]);
+    if (nextScript == NUM_SCRIPT && nextFuzz <= now)
+    {
+      send(&fuzzPool[fuzzNext() % NUM_FUZZ]);
+      nextFuzz = now + HOST_FUZZ_MIN + fuzzNext() % (HOST_FUZZ_MAX - HOST_FUZZ_MIN);
+    }
+
+    /* every step moves the clock by one second, each now comes once */
+    if (now == HOST_SWAP_AT)
+    {
+      bus.setConnected(swapped, false);
+      last->probe[PROBE_LIQUID] = spare;
+    }
+    if (now == HOST_SWAP_AT + HOST_SWAP_GAP) bus.setConnected(spare, true);
+
+    hostRun(HOST_STEP);
+    stepPlants(&params);
+  }
+  wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+  printf("virtual time  %u h, seed %u\n", hours, seed);
+  for (uint8_t c = 0; c < numChambers; c++)
+  {
+    printf("chamber %u     %.2f °C, liquid %.2f °C, toggles fan %u, cool %u, heat %u\n", c + 1,
+           sim[c].plant.air, sim[c].plant.liquid, sim[c].toggles[PLANT_FAN],
+           sim[c].toggles[PLANT_COOL], sim[c].toggles[PLANT_HEAT]);
+  }
+  printf("commands      %u sent, %u replies, %u unsolicited, %u unanswered\n",
+         answers.sent, answers.replies, answers.unsolicited, (unsigned)answers.pending.size());
+  printf("latency       max %u ms, %u over %u ms\n", answers.maxLatency, answers.late, HOST_REPLY_LIMIT);
+  if (hours * 3600 > HOST_SWAP_AT + HOST_SWAP_GAP)
+  {
+    if (memcmp(chambers[numChambers - 1].probe[PROBE_LIQUID], bus.rom(spare), 8) != 0)
+    {
+      violation(numChambers - 1, "the spare probe was not given the liquid role");
+    }
+    else printf("probe swap    chamber %u liquid moved to the spare\n", numChambers);
+  }
+  printf("1-wire        %u resets, %u slots\n", bus.resets, bus.slots);
+  printf("http requests %u\n", hostTelegramRequests());
+  printf("replies hash  %016llx\n", (unsigned long long)answers.digest);
+  printf("violations    %u\n", violations);
+  fprintf(stderr, "wall time     %.2f s, %.0fx real time\n", wall, hours * 3600.0 / wall);
+
+  hostExit(violations || answers.late ? 1 : 0);
+  return 0;
+}
+
+#endif /* !PIO_UNIT_TESTING */
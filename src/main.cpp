@@ -24,25 +24,39 @@
 #include <WiFiClientSecure.h>
 #include <UniversalTelegramBot.h>
 #include "sensorReadings.h"
+#include "sampleExchange.h"
+#include "botSender.h"
+#include "tempHistory.h"
+#include "fermentLog.h"
+#include "tempStats.h"
+#include "tempControl.h"
+#include "chamber.h"
+#include "probeScan.h"
 #include "tokens.h"
-#include <Preferences.h>
+#include <LittleFS.h>
 
 #define PRINT_ADDRESS_DS18B20
 
-#define HEAT_PIN (25)
-#define COOL_PIN (26)
-#define FAN_PIN  (27)
-
-#define MODE_OFF  (0)
-#define MODE_AUTO (1)
-#define MODE_HEAT (2)
-#define MODE_COOL (3)
-#define UNDEFINED (0)
-#define HEATING   (1)
-#define COOLING   (2)
-#define COOL_WAIT (120000)
-#define FAN_WAIT  (300000)
-#define READ_WAIT (250)
+/* relays of the first chamber, then of the chambers tokens.h adds with
+ * DS18B20_CHAMBER_2/DS18B20_LIQUID_2 and DS18B20_CHAMBER_3/... */
+#define HEAT_PIN   (25)
+#define COOL_PIN   (26)
+#define FAN_PIN    (27)
+#define HEAT_PIN_2 (32)
+#define COOL_PIN_2 (33)
+#define FAN_PIN_2  (14)
+#define HEAT_PIN_3 (16)
+#define COOL_PIN_3 (17)
+#define FAN_PIN_3  (18)
+
+#define READ_WAIT (500)
+#define READ_WAIT_STEADY (2500)  /* well below SAMPLE_MAX_AGE */
+#define CLOCK_VALID    (1600000000)  /* time() past this means NTP answered */
+#define CLOCK_WAIT     (10000)
+/* vTempControl notification bits */
+#define CTRL_EVT_SAMPLE   (1 << 0)
+#define CTRL_EVT_SETPOINT (1 << 1)
+#define CTRL_EVT_MODE     (1 << 2)
 #define WRITTEN_ADD (0)
 #define TH_ADD      (1)
 #define THH_ADD     (2)
@@ -53,266 +67,581 @@
 #define EEPROM_S    (7)
 
 const unsigned long BOT_MTBS = 1000; // mean time between scan messages
+const int BOT_LONG_POLL = 20; // seconds telegram holds getUpdates waiting for messages
+const int BOT_BATCH = 8;      // updates fetched per getUpdates
+static_assert(BOT_BATCH >= 1 && BOT_BATCH <= HANDLE_MESSAGES,
+              "bot.messages[] holds HANDLE_MESSAGES updates, build with -DHANDLE_MESSAGES");
 
 WiFiClientSecure secured_client;
+WiFiClientSecure send_client;   /* replies don't wait behind the long poll */
 UniversalTelegramBot bot(BOT_TOKEN, secured_client);
 
-Preferences pref;
+chamber_t chambers[] = {
+  { { DS18B20_CHAMBER, DS18B20_LIQUID }, HEAT_PIN, COOL_PIN, FAN_PIN },
+#ifdef DS18B20_CHAMBER_2
+  { { DS18B20_CHAMBER_2, DS18B20_LIQUID_2 }, HEAT_PIN_2, COOL_PIN_2, FAN_PIN_2 },
+#endif
+#ifdef DS18B20_CHAMBER_3
+  { { DS18B20_CHAMBER_3, DS18B20_LIQUID_3 }, HEAT_PIN_3, COOL_PIN_3, FAN_PIN_3 },
+#endif
+};
+#define NUM_CHAMBERS (sizeof(chambers) / sizeof(chambers[0]))
+const uint8_t numChambers = NUM_CHAMBERS;
+static_assert(NUM_CHAMBERS <= SAMPLE_CHANNELS, "every chamber needs a sample channel");
+
+/* chamber the bot commands act on, see /chamber. Only the message task
+ * touches it */
+uint8_t botChamber = 0;
+
+TaskHandle_t tempControlHandle = NULL;
+
+/* wake vTempControl up with one of the CTRL_EVT_* bits */
+void notifyControl(uint32_t evt)
+{
+  if (tempControlHandle != NULL) xTaskNotify(tempControlHandle, evt, eSetBits);
+}
 
-float refTemp, chamberTemp, liquidTemp;
-float tempH, tempHH, tempL, tempLL;
-UBaseType_t selectedMode;
-UBaseType_t currentMode  = UNDEFINED;
-uint8_t chamberAdd[] = DS18B20_CHAMBER;
-uint8_t liquidAdd[]  = DS18B20_LIQUID;
+/* setpoints the bot can change, indexed by the SP_* constants */
+#define SP_H  (0)
+#define SP_HH (1)
+#define SP_L  (2)
+#define SP_LL (3)
+
+typedef struct {
+  size_t      offset; /* in ctrlSettings_t */
+  const char *key;    /* Preferences key */
+  const char *label;
+} setpoint_t;
+
+static const setpoint_t setpoints[] = {
+  { offsetof(ctrlSettings_t, tempH),  "tempH",  "Temperatura superior de histéresis" },
+  { offsetof(ctrlSettings_t, tempHH), "tempHH", "Temperatura superior de cambio de modo" },
+  { offsetof(ctrlSettings_t, tempL),  "tempL",  "Temperatura inferior de histéresis" },
+  { offsetof(ctrlSettings_t, tempLL), "tempLL", "Temperatura inferior de cambio de modo" },
+};
+
+float *setpointValue(chamber_t *c, const setpoint_t *sp)
+{
+  return (float *)((char *)&c->settings + sp->offset);
+}
 
-bool coolingState = false;
-bool heatingState = false;
-bool blowingState = false;
-bool canRestart   = false;
-bool canStopFan   = false;
+/* what a command handler gets to work with */
+typedef struct {
+  const char         *chat_id;
+  const char         *from_name;
+  const char         *arg;      /* text after the command, "" if none */
+  chamber_t          *chamber;  /* selected with /chamber */
+  const tempSample_t *sample;   /* latest of that chamber */
+} cmdContext_t;
+
+typedef struct botCommand botCommand_t;
+typedef void (*cmdHandler_t)(const cmdContext_t *ctx, const botCommand_t *cmd);
+
+struct botCommand {
+  const char   *name;
+  cmdHandler_t  handler;
+  uint8_t       sel;    /* mode or setpoint the handler acts on */
+  int8_t        step;   /* setpoint increment in °C */
+};
+
+void replySetpoint(const char *chat_id, chamber_t *c, const setpoint_t *sp)
+{
+  String tempString = String(sp->label) + ": " + String(*setpointValue(c, sp)) + "°C\n";
+  queueReply(chat_id, tempString.c_str(), "Markdown");
+}
 
-void handleNewMessages(int numNewMessages)
+void storeSetpoint(chamber_t *c, const setpoint_t *sp, float value)
 {
-  static bool waitingFloat = false;
-  static String last;
-  Serial.print("handleNewMessages ");
-  Serial.println(numNewMessages);
+  value = constrain(value, SETPOINT_MIN, SETPOINT_MAX);
+  *setpointValue(c, sp) = value;
+  c->pref.putFloat(sp->key, value);
+  notifyControl(CTRL_EVT_SETPOINT);
+}
 
-  for (int i = 0; i < numNewMessages; i++)
+/* /status text, kept between calls and rendered again only when one of
+ * the values it shows changed */
+#define STATUS_SIZE (768)
+
+typedef struct {
+  uint8_t     index;
+  UBaseType_t selectedMode;
+  UBaseType_t currentMode;
+  bool        blowing, cooling, heating;
+  float       chamber, liquid;
+  float       tH, tL, tHH, tLL;
+} statusKey_t;
+
+static const char STATUS_FMT[] PROGMEM =
+  "Modo de operación seleccionado: %s\n"
+  "Modo de operación en funcionamiento: %s\n"
+  "Ventilador: %s\n"
+  "Enfriador: %s\n"
+  "Calentador: %s\n"
+  "Temperatura en la camara: %.2f°C\n"
+  "Temperatura en el liquido: %.2f°C\n"
+  "Temperatura superior de histéresis: %.2f°C\n"
+  "Temperatura inferior de histéresis: %.2f°C\n"
+  "Temperatura superior de cambio de modo: %.2f°C\n"
+  "Temperatura inferior de cambio de modo: %.2f°C\n";
+
+const char *selectedModeName(UBaseType_t mode)
+{
+  switch (mode)
   {
-    String chat_id = bot.messages[i].chat_id;
-    String text = bot.messages[i].text;
-    Serial.println(text);
-    Serial.println(last);
-    Serial.println(waitingFloat);
+    case MODE_OFF :  return "Apagado";
+    case MODE_AUTO : return "Automatico";
+    case MODE_COOL : return "Enfriamiento";
+    case MODE_HEAT : return "Calentamiento";
+    case MODE_PID :  return "PID";
+    default:         return "No reconocido";
+  }
+}
 
-    String from_name = bot.messages[i].from_name;
-    if (from_name == "")
-      from_name = "Guest";
+const char *currentModeName(UBaseType_t mode)
+{
+  switch (mode)
+  {
+    case UNDEFINED : return "Sin definir";
+    case HEATING :   return "Calentamiento";
+    case COOLING :   return "Enfriamiento";
+    default:         return "No reconocido";
+  }
+}
 
-    if (text == "/status")
-    {
-      String statusString;
-      String sMode;
-      String sOperating;
-      String sFan;
-      String sCooler;
-      String sHeater;
-      switch (selectedMode)
-      {
-        case MODE_OFF :
-          sMode = "Apagado";
-          break;
-        case MODE_AUTO :
-          sMode = "Automatico";
-          break;
-        case MODE_COOL :
-          sMode = "Enfriamiento";
-          break;
-        case MODE_HEAT :
-          sMode = "Calentamiento";
-          break;
-        default:
-          sMode = "No reconocido";
-      }
-      switch (currentMode)
-      {
-        case UNDEFINED :
-          sOperating = "Sin definir";
-          break;
-        case HEATING :
-          sOperating = "Calentamiento";
-          break;
-        case COOLING :
-          sOperating = "Enfriamiento";
-          break;
-        default:
-          sOperating = "No reconocido";
-      }
-      sFan    = blowingState ? "Encendido" : "Apagado";
-      sCooler = coolingState ? "Encendido" : "Apagado";
-      sHeater = heatingState ? "Encendido" : "Apagado";
-      statusString = "Modo de operación seleccionado: " + sMode + "\n" +
-                    "Modo de operación en funcionamiento: " + sOperating + "\n" +
-                    "Ventilador: " + sFan + "\n" +
-                    "Enfriador: " + sCooler + "\n" +
-                    "Calentador: " + sHeater + "\n" +
-                    "Temperatura en la camara: " + String(chamberTemp) + "°C\n" +
-                    "Temperatura en el liquido: " + String(liquidTemp) + "°C\n" +
-                    "Temperatura superior de histéresis: " + String(tempH) + "°C\n" +
-                    "Temperatura inferior de histéresis: " + String(tempL) + "°C\n" +
-                    "Temperatura superior de cambio de modo: " + String(tempHH) + "°C\n" +
-                    "Temperatura inferior de cambio de modo: " + String(tempLL) + "°C\n";
-      bot.sendMessage(chat_id, statusString, "Markdown");
-    }
+const char *renderStatus(const chamber_t *c, const tempSample_t *sample)
+{
+  static char        text[STATUS_SIZE];
+  static statusKey_t rendered;
+  static bool        valid = false;
+  statusKey_t key;
+  int len = 0;
+
+  memset(&key, 0, sizeof(key));  /* padding takes part in memcmp */
+  key.index        = c - chambers;
+  key.selectedMode = c->settings.selectedMode;
+  key.currentMode  = c->state.currentMode;
+  key.blowing      = c->state.blowing;
+  key.cooling      = c->state.cooling;
+  key.heating      = c->state.heating;
+  key.chamber      = sample->temp[PROBE_CHAMBER];
+  key.liquid       = sample->temp[PROBE_LIQUID];
+  key.tH  = c->settings.tempH;
+  key.tL  = c->settings.tempL;
+  key.tHH = c->settings.tempHH;
+  key.tLL = c->settings.tempLL;
+
+  if (valid && memcmp(&key, &rendered, sizeof(key)) == 0) return text;
+
+  if (NUM_CHAMBERS > 1) len = snprintf(text, sizeof(text), "Cámara %u\n", key.index + 1);
+  snprintf_P(text + len, sizeof(text) - len, STATUS_FMT,
+             selectedModeName(key.selectedMode),
+             currentModeName(key.currentMode),
+             key.blowing ? "Encendido" : "Apagado",
+             key.cooling ? "Encendido" : "Apagado",
+             key.heating ? "Encendido" : "Apagado",
+             key.chamber, key.liquid,
+             key.tH, key.tL, key.tHH, key.tLL);
+  rendered = key;
+  valid = true;
+  return text;
+}
 
-    if (text == "/getTemp")
-    {
-      String tempString = "Temperatura en la camara: " + String(chamberTemp) + "°C\n" +
-                          "Temperatura en el liquido: " + String(liquidTemp) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
+void cmdStatus(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  queueReply(ctx->chat_id, renderStatus(ctx->chamber, ctx->sample), "Markdown");
+}
 
-    if (text == "/getChamberTemp")
-    {
-      String tempString = "Temperatura en la camara: " + String(chamberTemp) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
+void cmdGetTemp(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  tempSample_t sample;
+  String tempString;
 
-    if (text == "/getLiquidTemp")
-    {
-      String tempString = "Temperatura en el liquido: " + String(liquidTemp) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
+  for (uint8_t i = 0; i < NUM_CHAMBERS; i++)
+  {
+    readSample(i, &sample);
+    if (NUM_CHAMBERS > 1) tempString += "Cámara " + String(i + 1) + "\n";
+    tempString += "Temperatura en la camara: " + String(sample.temp[PROBE_CHAMBER]) + "°C\n" +
+                  "Temperatura en el liquido: " + String(sample.temp[PROBE_LIQUID]) + "°C\n";
+  }
+  queueReply(ctx->chat_id, tempString.c_str(), "Markdown");
+}
 
-    if (text == "/setModeOff") {
-      selectedMode = MODE_OFF;
-      pref.putULong("selMode", selectedMode);
-    }
-    if (text == "/setModeAuto") {
-      selectedMode = MODE_AUTO;
-      pref.putULong("selMode", selectedMode);
-    }
-    if (text == "/setModeCool") {
-      selectedMode = MODE_COOL;
-      pref.putULong("selMode", selectedMode);
-    }
-    if (text == "/setModeHeat") {
-      selectedMode = MODE_HEAT;
-      pref.putULong("selMode", selectedMode);
-    }
-    if (waitingFloat) {
-      if (last == "/setTempH") {
-        tempH = text.toFloat();
-        pref.putFloat("tempH", tempH);
-        String tempString = "Temperatura superior de histéresis: " + String(tempH) + "°C\n";
-        bot.sendMessage(chat_id, tempString, "Markdown");
-      }
-      if (last == "/setTempHH") {
-        tempHH = text.toFloat();
-        pref.putFloat("tempHH", tempHH);
-        String tempString = "Temperatura superior de cambio de modo: " + String(tempHH) + "°C\n";
-        bot.sendMessage(chat_id, tempString, "Markdown");
-      }
-      if (last == "/setTempL") {
-        tempL = text.toFloat();
-        pref.putFloat("tempL", tempL);
-        String tempString = "Temperatura inferior de histéresis: " + String(tempL) + "°C\n";
-        bot.sendMessage(chat_id, tempString, "Markdown");
-      }
-      if (last == "/setTempLL") {
-        tempLL = text.toFloat();
-        pref.putFloat("tempLL", tempLL);
-        String tempString = "Temperatura inferior de cambio de modo: " + String(tempLL) + "°C\n";
-        bot.sendMessage(chat_id, tempString, "Markdown");
-      }
-      waitingFloat = false;
-    }
-    if (text == "/setTempH" || text == "/setTempHH" || text == "/setTempL" || text == "/setTempLL") {
-      last = text;
-      waitingFloat = true;
-    }
-    
-    if (text == "/setTempHp")
-    {
-      tempH = tempH + 1.0;
-      pref.putFloat("tempH", tempH);
-      String tempString = "Temperatura superior de histéresis: " + String(tempH) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
-    if (text == "/setTempHHp")   
-    {
-      tempHH = tempHH + 1.0;
-      pref.putFloat("tempHH", tempHH);
-      String tempString = "Temperatura superior de cambio de modo: " + String(tempHH) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
-    if (text == "/setTempLp")   
-    {
-      tempL = tempL + 1.0;
-      pref.putFloat("tempL", tempL);
-      String tempString = "Temperatura inferior de histéresis: " + String(tempL) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
-    if (text == "/setTempLLp")   
-    {
-      tempLL = tempLL + 1.0;
-      pref.putFloat("tempLL", tempLL);
-      String tempString = "Temperatura inferior de cambio de modo: " + String(tempLL) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
-    if (text == "/setTempHm")   
-    {
-      tempH = tempH - 1.0;
-      pref.putFloat("tempH", tempH);
-      String tempString = "Temperatura superior de histéresis: " + String(tempH) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
-    }
-    if (text == "/setTempHHm")   
+void cmdGetChamberTemp(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  String tempString = "Temperatura en la camara: " + String(ctx->sample->temp[PROBE_CHAMBER]) + "°C\n";
+  queueReply(ctx->chat_id, tempString.c_str(), "Markdown");
+}
+
+void cmdGetLiquidTemp(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  String tempString = "Temperatura en el liquido: " + String(ctx->sample->temp[PROBE_LIQUID]) + "°C\n";
+  queueReply(ctx->chat_id, tempString.c_str(), "Markdown");
+}
+
+void cmdSetMode(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  ctx->chamber->settings.selectedMode = cmd->sel;
+  ctx->chamber->pref.putULong("selMode", cmd->sel);
+  notifyControl(CTRL_EVT_MODE);
+}
+
+/* /setTempH 21.5 */
+void cmdSetTemp(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  const setpoint_t *sp = &setpoints[cmd->sel];
+  char *end;
+  float value = strtof(ctx->arg, &end);
+
+  while (*end == ' ') end++;
+  if (end == ctx->arg || *end != '\0' || !isfinite(value))
+  {
+    String usage = String("Uso: ") + cmd->name + " <temperatura en °C, de " +
+                   SETPOINT_MIN + " a " + SETPOINT_MAX + ">\n";
+    queueReply(ctx->chat_id, usage.c_str(), "");
+    return;
+  }
+  storeSetpoint(ctx->chamber, sp, value);
+  replySetpoint(ctx->chat_id, ctx->chamber, sp);
+}
+
+/* /setTempHp, /setTempHm... */
+void cmdStepTemp(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  const setpoint_t *sp = &setpoints[cmd->sel];
+  storeSetpoint(ctx->chamber, sp, *setpointValue(ctx->chamber, sp) + cmd->step);
+  replySetpoint(ctx->chat_id, ctx->chamber, sp);
+}
+
+/* /history [horas]: HISTORY_LINES readings spread over the last hours.
+ * The history follows the first chamber, the reply says so */
+#define HISTORY_LINES (12)
+#define HISTORY_HOURS (HISTORY_LEN * (HISTORY_PERIOD / 1000) / 3600)  /* hours kept */
+#define FIRST_ONLY    "Cámara 1 (solo se registra la primera)\n"
+
+void cmdHistory(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  static char    text[BOT_REPLY_SIZE];
+  historyPoint_t point;
+  uint32_t       span, back;
+  int            len, lines;
+  long           hours = 12;
+  char          *end;
+
+  if (ctx->arg[0] != '\0')
+  {
+    hours = strtol(ctx->arg, &end, 10);
+    if (end == ctx->arg || hours < 1) hours = 12;
+    if (hours > HISTORY_HOURS) hours = HISTORY_HOURS;
+  }
+  span = (uint32_t)hours * 3600000UL / HISTORY_PERIOD;
+  if (span > historyCount()) span = historyCount();
+  if (span == 0)
+  {
+    queueReply(ctx->chat_id, "Sin historial todavía\n", "");
+    return;
+  }
+
+  lines = span < HISTORY_LINES ? span : HISTORY_LINES;
+  len = snprintf(text, sizeof(text), "%shace   cámara  líquido  V E C\n",
+                 NUM_CHAMBERS > 1 ? FIRST_ONLY : "");
+  for (int i = lines - 1; i >= 0; i--)
+  {
+    back = lines > 1 ? (uint32_t)i * (span - 1) / (lines - 1) : 0;
+    if (!historyPointAgo(back, &point)) continue;
+    back = back * HISTORY_PERIOD / 60000;  /* minutes */
+    len += snprintf(text + len, sizeof(text) - len, "%2luh%02lu  ",
+                    (unsigned long)back / 60, (unsigned long)back % 60);
+    for (int p = 0; p < SAMPLE_PROBES; p++)
     {
-      tempHH = tempHH - 1.0;
-      pref.putFloat("tempHH", tempHH);
-      String tempString = "Temperatura superior de cambio de modo: " + String(tempHH) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
+      if (point.flags & HIST_INVALID(p))
+        len += snprintf(text + len, sizeof(text) - len, "   --   ");
+      else
+        len += snprintf(text + len, sizeof(text) - len, "%6.2f  ", point.temp[p]);
     }
-    if (text == "/setTempLm")   
+    len += snprintf(text + len, sizeof(text) - len, "%c %c %c\n",
+                    point.flags & HIST_FAN  ? '*' : '-',
+                    point.flags & HIST_COOL ? '*' : '-',
+                    point.flags & HIST_HEAT ? '*' : '-');
+    if (len >= (int)sizeof(text)) break;
+  }
+  queueReply(ctx->chat_id, text, "");
+}
+
+static const char* const probeNames[SAMPLE_PROBES] = { "cámara", "líquido" };
+
+/* /stats: min, max, mean and trend of both probes of the first chamber
+ * per window, the reply says which chamber */
+void cmdStats(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  static const char* const windowNames[STATS_WINDOWS] = { "1 min", "1 h", "24 h" };
+  static char text[BOT_REPLY_SIZE];
+  tempStats_t st;
+  int len = 0;
+
+  if (NUM_CHAMBERS > 1) len = snprintf(text, sizeof(text), FIRST_ONLY);
+  for (uint8_t w = 0; w < STATS_WINDOWS && len < (int)sizeof(text); w++)
+  {
+    for (uint8_t p = 0; p < SAMPLE_PROBES && len < (int)sizeof(text); p++)
     {
-      tempL = tempL - 1.0;
-      pref.putFloat("tempL", tempL);
-      String tempString = "Temperatura inferior de histéresis: " + String(tempL) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
+      if (!statsGet(w, p, &st))
+      {
+        len += snprintf(text + len, sizeof(text) - len, "%s %s: sin datos\n",
+                        windowNames[w], probeNames[p]);
+        continue;
+      }
+      len += snprintf(text + len, sizeof(text) - len,
+                      "%s %s: min %.2f max %.2f media %.2f tendencia %+.2f°C/h\n",
+                      windowNames[w], probeNames[p], st.min, st.max, st.mean, st.slope);
     }
-    if (text == "/setTempLLm")   
+  }
+  queueReply(ctx->chat_id, text, "");
+}
+
+/* /chamber 2: the chamber the next commands act on. Without a number,
+ * the list of chambers */
+void cmdChamber(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  static char  text[BOT_REPLY_SIZE];
+  tempSample_t sample;
+  char *end;
+  long  n;
+  int   len = 0;
+
+  if (ctx->arg[0] != '\0')
+  {
+    n = strtol(ctx->arg, &end, 10);
+    while (*end == ' ') end++;
+    if (end == ctx->arg || *end != '\0' || n < 1 || n > (long)NUM_CHAMBERS)
     {
-      tempLL = tempLL - 1.0;
-      pref.putFloat("tempLL", tempLL);
-      String tempString = "Temperatura inferior de cambio de modo: " + String(tempLL) + "°C\n";
-      bot.sendMessage(chat_id, tempString, "Markdown");
+      snprintf(text, sizeof(text), "Uso: /chamber <1 a %u>\n", (unsigned)NUM_CHAMBERS);
+      queueReply(ctx->chat_id, text, "");
+      return;
     }
-    
-    if (text == "/start")
+    botChamber = n - 1;
+  }
+
+  for (uint8_t i = 0; i < NUM_CHAMBERS && len < (int)sizeof(text); i++)
+  {
+    readSample(i, &sample);
+    len += snprintf(text + len, sizeof(text) - len, "%c Cámara %u: %s, %.2f°C / %.2f°C\n",
+                    i == botChamber ? '>' : ' ', i + 1,
+                    selectedModeName(chambers[i].settings.selectedMode),
+                    sample.temp[PROBE_CHAMBER], sample.temp[PROBE_LIQUID]);
+  }
+  queueReply(ctx->chat_id, text, "");
+}
+
+/* /probes: the ROMs the scan found and the role of each */
+void cmdProbes(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  static char text[BOT_REPLY_SIZE];
+  probeSlot_t list[PROBE_SLOTS];
+  int len = 0;
+
+  probeScanList(list);
+  for (uint8_t i = 0; i < PROBE_SLOTS && len < (int)sizeof(text); i++)
+  {
+    if (!list[i].used) continue;
+    len += snprintf(text + len, sizeof(text) - len, "%u  ", i + 1);
+    for (uint8_t b = 0; b < 8 && len < (int)sizeof(text); b++)
+      len += snprintf(text + len, sizeof(text) - len, "%02X", list[i].rom[b]);
+    if (list[i].role == PROBE_NO_ROLE)
+      len += snprintf(text + len, sizeof(text) - len, "  sin asignar");
+    else
+      len += snprintf(text + len, sizeof(text) - len, "  cámara %u, %s",
+                      list[i].role / SAMPLE_PROBES + 1, probeNames[list[i].role % SAMPLE_PROBES]);
+    len += snprintf(text + len, sizeof(text) - len, "%s\n",
+                    list[i].missed >= PROBE_MISS_LIMIT ? " (ausente)" : "");
+  }
+  queueReply(ctx->chat_id, len > 0 ? text : "Ninguna sonda encontrada todavía\n", "");
+}
+
+/* /setProbe 3 l: the probe /probes lists as 3 becomes the liquid (l) or
+ * chamber (c) probe of the selected chamber */
+void cmdSetProbe(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  char        text[96];
+  char       *end;
+  long        n     = strtol(ctx->arg, &end, 10);
+  int         probe = -1;
+  probeSlot_t list[PROBE_SLOTS];
+
+  while (*end == ' ') end++;
+  if (strcmp(end, "c") == 0) probe = PROBE_CHAMBER;
+  if (strcmp(end, "l") == 0) probe = PROBE_LIQUID;
+  if (end == ctx->arg || probe < 0 || n < 1 || n > PROBE_SLOTS)
+  {
+    queueReply(ctx->chat_id, "Uso: /setProbe <número en /probes> <c|l>\n", "");
+    return;
+  }
+  probeScanList(list);
+  if (list[n - 1].used && list[n - 1].missed >= PROBE_MISS_LIMIT)
+  {
+    snprintf(text, sizeof(text), "La sonda %ld está ausente, no se asigna\n", n);
+    queueReply(ctx->chat_id, text, "");
+    return;
+  }
+  if (!probeAssign(n - 1, (ctx->chamber - chambers) * SAMPLE_PROBES + probe))
+  {
+    queueReply(ctx->chat_id, "Uso: /setProbe <número en /probes> <c|l>\n", "");
+    return;
+  }
+  snprintf(text, sizeof(text), "Sonda %ld: cámara %u, %s\n", n,
+           (unsigned)(ctx->chamber - chambers) + 1, probeNames[probe]);
+  queueReply(ctx->chat_id, text, "");
+}
+
+void cmdStart(const cmdContext_t *ctx, const botCommand_t *cmd)
+{
+  String welcome = "Hola, " + String(ctx->from_name) + ".\n";
+  welcome += "Por acá se interactúa con el control de procesos de cerveza casera.\n\n";
+  welcome += "/getTemp : lista todas las temperaturas leídas\n";
+  welcome += "/chamber 2 : elige la cámara que manejan los comandos\n";
+  welcome += "/getChamberTemp : Temperatura en la cámara\n";
+  welcome += "/getLiquidTemp : Temperatura en el líquido\n";
+  welcome += "/setModeAuto : para que enfríe o caliente según haga falta\n";
+  welcome += "/setModeCool : modo solo enfriamiento\n";
+  welcome += "/setModeHeat : modo solo calentamiento\n";
+  welcome += "/setModeOff : modo apagado\n";
+  welcome += "/setModePid : lleva el líquido al medio de la histéresis\n";
+  welcome += "/setTempH 20.5 : fija la temperatura superior de histéresis\n";
+  welcome += "/setTempL 18.5 : fija la temperatura inferior de histéresis\n";
+  welcome += "/setTempHp : incrementa temperaturra de referencia\n";
+  welcome += "/setTempLm : decrementa temperaturra de referencia\n";
+  welcome += "/history 24 : temperaturas y reles de las últimas 24 horas\n";
+  welcome += "/stats : mínimo, máximo, media y tendencia por ventana\n";
+  welcome += "/probes : sondas en el bus, /setProbe 3 l asigna la 3 al líquido\n";
+  welcome += "/status : Estado general del sistema.\n";
+  queueReply(ctx->chat_id, welcome.c_str(), "Markdown");
+}
+
+/* command table, MUST stay sorted by strcmp (checked at compile time) so
+ * lookups are a binary search */
+static constexpr botCommand_t commands[] = {
+  { "/chamber",        cmdChamber,        0,         0 },
+  { "/getChamberTemp", cmdGetChamberTemp, 0,         0 },
+  { "/getLiquidTemp",  cmdGetLiquidTemp,  0,         0 },
+  { "/getTemp",        cmdGetTemp,        0,         0 },
+  { "/history",        cmdHistory,        0,         0 },
+  { "/probes",         cmdProbes,         0,         0 },
+  { "/setModeAuto",    cmdSetMode,        MODE_AUTO, 0 },
+  { "/setModeCool",    cmdSetMode,        MODE_COOL, 0 },
+  { "/setModeHeat",    cmdSetMode,        MODE_HEAT, 0 },
+  { "/setModeOff",     cmdSetMode,        MODE_OFF,  0 },
+  { "/setModePid",     cmdSetMode,        MODE_PID,  0 },
+  { "/setProbe",       cmdSetProbe,       0,         0 },
+  { "/setTempH",       cmdSetTemp,        SP_H,      0 },
+  { "/setTempHH",      cmdSetTemp,        SP_HH,     0 },
+  { "/setTempHHm",     cmdStepTemp,       SP_HH,    -1 },
+  { "/setTempHHp",     cmdStepTemp,       SP_HH,     1 },
+  { "/setTempHm",      cmdStepTemp,       SP_H,     -1 },
+  { "/setTempHp",      cmdStepTemp,       SP_H,      1 },
+  { "/setTempL",       cmdSetTemp,        SP_L,      0 },
+  { "/setTempLL",      cmdSetTemp,        SP_LL,     0 },
+  { "/setTempLLm",     cmdStepTemp,       SP_LL,    -1 },
+  { "/setTempLLp",     cmdStepTemp,       SP_LL,     1 },
+  { "/setTempLm",      cmdStepTemp,       SP_L,     -1 },
+  { "/setTempLp",      cmdStepTemp,       SP_L,      1 },
+  { "/start",          cmdStart,          0,         0 },
+  { "/stats",          cmdStats,          0,         0 },
+  { "/status",         cmdStatus,         0,         0 },
+};
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+constexpr int constStrcmp(const char *a, const char *b)
+{
+  return (*a != *b || *a == '\0') ? (unsigned char)*a - (unsigned char)*b
+                                  : constStrcmp(a + 1, b + 1);
+}
+
+constexpr bool commandsSorted(size_t i)
+{
+  return i + 1 >= NUM_COMMANDS ||
+         (constStrcmp(commands[i].name, commands[i + 1].name) < 0 && commandsSorted(i + 1));
+}
+static_assert(commandsSorted(0), "commands[] must be sorted by name");
+
+int compareCommand(const void *key, const void *entry)
+{
+  return strcmp((const char *)key, ((const botCommand_t *)entry)->name);
+}
+
+/* split "/cmd@bot arg" into the command name and its argument, then run
+ * the handler. Unknown commands are ignored */
+void dispatchCommand(const char *text, cmdContext_t *ctx)
+{
+  char name[24];
+  size_t len = strcspn(text, " @");
+  const botCommand_t *cmd;
+
+  if (len >= sizeof(name)) return;
+  memcpy(name, text, len);
+  name[len] = '\0';
+
+  cmd = (const botCommand_t *)bsearch(name, commands, NUM_COMMANDS,
+                                      sizeof(commands[0]), compareCommand);
+  if (cmd == NULL) return;
+
+  text += strcspn(text, " ");
+  while (*text == ' ') text++;
+  ctx->arg = text;
+  cmd->handler(ctx, cmd);
+}
+
+void handleNewMessages(int numNewMessages)
+{
+  tempSample_t sample;
+  cmdContext_t ctx;
+  Serial.print("handleNewMessages ");
+  Serial.println(numNewMessages);
+
+  for (int i = 0; i < numNewMessages; i++)
+  {
+    const char *text = bot.messages[i].text.c_str();
+    Serial.println(text);
+
+    /* what is left of a cut command or chat id must not be acted upon */
+    if (bot.messages[i].text.truncated() || bot.messages[i].chat_id.truncated())
     {
-      String welcome = "Hola, " + from_name + ".\n";
-      welcome += "Por acá se interactúa con el control de procesos de cerveza casera.\n\n";
-      welcome += "/getTemp : lista todas las temperaturas leídas\n";
-      welcome += "/getChamberTemp : Temperatura en la cámara\n";
-      welcome += "/getLiquidTemp : Temperatura en el líquido\n";
-      welcome += "/setModeAuto : para que enfríe o caliente según haga falta\n";
-      welcome += "/setModeCool : modo solo enfriamiento\n";
-      welcome += "/setModeHeat : modo solo calentamiento\n";
-      welcome += "/setModeOff : modo apagado\n";
-      welcome += "/setTempHp : incrementa temperaturra de referencia\n";
-      welcome += "/setTempLm : decrementa temperaturra de referencia\n";
-      welcome += "/status : Estado general del sistema.\n";
-      bot.sendMessage(chat_id, welcome, "Markdown");
+      Serial.println("Message too long, dropped");
+      continue;
     }
+
+    /* a /chamber earlier in the batch applies to the messages after it */
+    readSample(botChamber, &sample);
+    ctx.chamber = &chambers[botChamber];
+    ctx.sample  = &sample;
+
+    ctx.chat_id   = bot.messages[i].chat_id.c_str();
+    ctx.from_name = bot.messages[i].from_name.c_str();
+    if (ctx.from_name[0] == '\0')
+      ctx.from_name = "Guest";
+
+    dispatchCommand(text, &ctx);
   }
 }
 
 /** tareas ********************************************/
-/* check for new messages */
-/* TODO make this task to execute with freeRTOS timer*/
+/* check for new messages. getUpdates long polls: it sleeps on the socket
+ * until a message arrives or BOT_LONG_POLL seconds pass */
 void vCheckNewMessagesTask(void *px)
 {
-  /* last time messages' scan has been done */
-  static unsigned long bot_now, bot_lasttime = millis();
+  unsigned long started;
+  int numNewMessages;
 
   while(1)
   {
-    bot_now = millis();
-    if ((bot_now - bot_lasttime > BOT_MTBS) || (bot_now < bot_lasttime))
+    started = millis();
+    numNewMessages = bot.getUpdates(bot.last_message_received + 1);
+    if (numNewMessages)
     {
-      int numNewMessages = bot.getUpdates(bot.last_message_received + 1);
-
-      while (numNewMessages)
-      {
-        Serial.println("got response");
-        handleNewMessages(numNewMessages);
-        numNewMessages = bot.getUpdates(bot.last_message_received + 1);
-      }
-
-      bot_lasttime = millis();
+      Serial.println("got response");
+      handleNewMessages(numNewMessages);
+    }
+    else if (millis() - started < BOT_MTBS)
+    {
+      /* failed well before the long poll timeout, don't hammer the server */
+      vTaskDelay(pdMS_TO_TICKS(BOT_MTBS));
     }
   }
 
@@ -320,16 +649,87 @@ void vCheckNewMessagesTask(void *px)
   vTaskDelete(NULL);
 }
 
-/* sensor readings in a separate task */
+/* refill the RAM history from the flash log after a reset */
+typedef struct {
+  uint32_t next;     /* minute the next history entry stands for */
+  bool     started;
+} restoreState_t;
+
+void restoreEntry(uint32_t minute, const historyPoint_t* point, void* arg)
+{
+  restoreState_t* st = (restoreState_t*)arg;
+  historyPoint_t  gap = { { 0 }, HIST_INVALID(PROBE_CHAMBER) | HIST_INVALID(PROBE_LIQUID) };
+
+  while (st->started && st->next < minute)
+  {
+    historyRestore(&gap);
+    st->next++;
+  }
+  historyRestore(point);
+  st->next    = minute + 1;
+  st->started = true;
+}
+
+void restoreHistory(uint32_t nowMinute)
+{
+  restoreState_t st = { 0, false };
+  historyPoint_t gap = { { 0 }, HIST_INVALID(PROBE_CHAMBER) | HIST_INVALID(PROBE_LIQUID) };
+  uint32_t n;
+
+  n = fermentLogReplay(nowMinute - (HISTORY_LEN - HISTORY_BLOCK), restoreEntry, &st);
+  /* minutes the board was off */
+  while (st.started && st.next < nowMinute)
+  {
+    historyRestore(&gap);
+    st.next++;
+  }
+  Serial.print("History entries restored: ");
+  Serial.println(n);
+}
+
+/* sensor readings in a separate task. The probes of every chamber share
+ * one conversion, each chamber gets its sample on its own channel */
 void vReadTempTask(void *px)
 {
-  static unsigned long currentTime, lastTime = millis();
+  static uint8_t*       probeAdds[NUM_CHAMBERS * SAMPLE_PROBES];
+  static DeviceAddress  probeRoms[NUM_CHAMBERS * SAMPLE_PROBES];
+  static int16_t        probeRaws[NUM_CHAMBERS * SAMPLE_PROBES];
+  dsReader_t   reader;
+  tempSample_t sample;
+  unsigned long waitMs;
+  int16_t *raws;
+
+  for (uint8_t c = 0; c < NUM_CHAMBERS; c++)
+  {
+    for (uint8_t i = 0; i < SAMPLE_PROBES; i++)
+    {
+      probeAdds[c * SAMPLE_PROBES + i] = chambers[c].probe[i];
+    }
+  }
+  dsReaderInit(&reader, probeAdds, probeRoms, probeRaws, NUM_CHAMBERS * SAMPLE_PROBES,
+               READ_WAIT * portTICK_PERIOD_MS, READ_WAIT_STEADY * portTICK_PERIOD_MS);
   while(1)
   {
-      chamberTemp = readDSTempC(chamberAdd);
-      liquidTemp  = readDSTempC( liquidAdd);
-      refTemp     = chamberTemp;
-      vTaskDelay(READ_WAIT);
+      if (dsReaderStep(&reader, millis(), &waitMs))
+      {
+        sample.stamp = millis();
+        for (uint8_t c = 0; c < NUM_CHAMBERS; c++)
+        {
+          raws = &probeRaws[c * SAMPLE_PROBES];
+          /* one multiply per probe here saves one in each reader of the
+           * sample: control, PID, stats and history all work in °C */
+          sample.valid = 0;
+          for (uint8_t i = 0; i < SAMPLE_PROBES; i++)
+          {
+            sample.temp[i] = DallasTemperature::rawToCelsius(raws[i]);
+            if (raws[i] != DEVICE_DISCONNECTED_RAW) sample.valid |= SAMPLE_VALID(i);
+          }
+          publishSample(c, &sample);
+          if (c == 0) statsAdd(&sample);
+        }
+        notifyControl(CTRL_EVT_SAMPLE);
+      }
+      vTaskDelay(pdMS_TO_TICKS(waitMs));
   }
 
   /* Must not exit, but if you leave the while(1) you can delete the task */
@@ -338,128 +738,49 @@ void vReadTempTask(void *px)
     
 /* check for temperature bounds - ¿log? */
 
-/* Temperature control */
+/* Temperature control. Runs on new samples, setpoint or mode changes
+ * and when a compressor/fan timer expires, see CTRL_EVT_*. The decisions
+ * are taken by controlStep(), this task feeds it and drives the relays,
+ * every chamber in turn on every wake up.
+ */
 void vTempControl(void* px)
 {
-  TickType_t xTimeOff = xTaskGetTickCount();
-  TickType_t xTimeCur;
+  ctrlSettings_t settings;
+  tempSample_t   sample;
+  chamber_t     *c;
+  uint32_t       events, waitMs, timeout;
+  uint8_t        chosen, driven;
+
+  for (uint8_t i = 0; i < NUM_CHAMBERS; i++) controlInit(&chambers[i].state, millis());
   while(1){
-    xTimeCur = xTaskGetTickCount();
-    if (xTimeCur < xTimeOff) xTimeOff = xTimeCur;
-    canRestart = xTimeCur - xTimeOff > COOL_WAIT ? true : false;
-    canStopFan = xTimeCur - xTimeOff > FAN_WAIT  ? true : false;
-    
-    if (selectedMode != MODE_OFF)
+    waitMs = CTRL_WAIT_FOREVER;
+    for (uint8_t i = 0; i < NUM_CHAMBERS; i++)
     {
-      /* mode changes */
-      switch (selectedMode)
-      {
-        case MODE_AUTO :
-          switch (currentMode)
-          {
-            case UNDEFINED :
-              if (refTemp > tempHH) currentMode = COOLING;
-              else if (refTemp < tempLL) currentMode = HEATING;
-              break;
-            case HEATING :
-              if (refTemp > tempHH) currentMode = COOLING;
-              break;
-            case COOLING :
-              if (refTemp < tempLL) currentMode = HEATING;
-              break;
-            default:
-              currentMode = UNDEFINED;
-          }
-          break;
-        case MODE_COOL :
-          currentMode = COOLING;
-          break;
-        case MODE_HEAT :
-          currentMode = HEATING;
-          break;
-        default:
-          currentMode  = UNDEFINED;
-          selectedMode = MODE_OFF;
-      }
-      /* temp control */
-      switch (currentMode)
-      {
-        case UNDEFINED :
-          coolingState = false;
-          heatingState = false;
-          if (blowingState && canStopFan)
-          {
-            blowingState = false;
-          }
-          break;
-        case COOLING :
-          if (heatingState)
-          {
-            xTimeOff = xTaskGetTickCount();
-            heatingState = false;
-          }
-          if (coolingState && (refTemp < tempL)) 
-          {
-            xTimeOff = xTaskGetTickCount();
-            coolingState = false;
-          } 
-          else if (!(coolingState))
-          {
-            if (canRestart && (refTemp > tempH))
-            {
-              coolingState = true;
-              blowingState = true;
-            }
-            else if (blowingState && canStopFan)
-            {
-              blowingState = false;
-            }
-          }
-          break;
-        case HEATING :
-          if (coolingState)
-          {
-            xTimeOff = xTaskGetTickCount();
-            coolingState = false;
-          }
-          if (heatingState && (refTemp > tempH)) 
-          {
-            xTimeOff = xTaskGetTickCount();
-            heatingState = false;
-          } 
-          else if (!(heatingState))
-          {
-            if (refTemp < tempL)
-            {
-              heatingState = true;
-              blowingState = true;
-            }
-            else if (blowingState && canStopFan)
-            {
-              blowingState = false;
-            }
-          }
-          break;
-        default:
-          currentMode = UNDEFINED;
-      }
-      blowingState ? digitalWrite(FAN_PIN, HIGH)  : digitalWrite(FAN_PIN,  LOW);
-      coolingState ? digitalWrite(COOL_PIN, HIGH) : digitalWrite(COOL_PIN, LOW);
-      heatingState ? digitalWrite(HEAT_PIN, HIGH) : digitalWrite(HEAT_PIN, LOW);
-    } else {
-      currentMode = UNDEFINED;
-      if (digitalRead(COOL_PIN))
+      c = &chambers[i];
+      readSample(i, &sample);
+      settings = c->settings;
+      chosen   = settings.selectedMode;
+
+      controlStep(&c->state, &settings, &sample, millis());
+
+      /* an unknown mode fell back to MODE_OFF. Store it only if the bot
+       * didn't select another mode meanwhile, that one wins */
+      if (settings.selectedMode != chosen)
       {
-        xTimeOff = xTaskGetTickCount();
+        __atomic_compare_exchange_n(&c->settings.selectedMode, &chosen, settings.selectedMode,
+                                    false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
       }
-      digitalWrite(COOL_PIN, LOW);
-      digitalWrite(HEAT_PIN, LOW);
-      digitalWrite(FAN_PIN,  LOW);
-      coolingState = false;
-      heatingState = false;
-      blowingState = false;
+      driven = c->driven;
+      chamberDriveRelays(c);
+      /* watch the transient closely */
+      if (c->driven != driven) dsReaderBoost();
+
+      if (i == 0) historyRecord(&sample, chamberRelays(c), millis());
+      timeout = controlTimeout(&c->state, &sample, millis());
+      if (timeout < waitMs) waitMs = timeout;
     }
-    vTaskDelay(500);
+    xTaskNotifyWait(0, 0xFFFFFFFF, &events,
+                    waitMs == CTRL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
   }
   /* Must not exit, but if you leave the while(1) you can delete the task */
   vTaskDelete(NULL);
@@ -470,13 +791,10 @@ void setup()
   Serial.begin(115200);
   Serial.println();
 
-  pinMode(FAN_PIN, OUTPUT); // initialize digital ledPin as an output.
-  pinMode(HEAT_PIN, OUTPUT);
-  pinMode(COOL_PIN, OUTPUT);
-  delay(10);
-  digitalWrite(FAN_PIN, LOW); // initialize pin as off (active LOW)
-  digitalWrite(HEAT_PIN, LOW);
-  digitalWrite(COOL_PIN, LOW);
+  // relays off, settings from Preferences
+  for (uint8_t i = 0; i < NUM_CHAMBERS; i++) chamberBegin(&chambers[i], i);
+  // probe addresses found by the scan override tokens.h
+  probeScanBegin();
 
   setupSensorsOnOneWire();
 
@@ -517,6 +835,11 @@ void setup()
   Serial.print(WIFI_SSID);
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
   secured_client.setCACert(TELEGRAM_CERTIFICATE_ROOT); // Add root certificate for api.telegram.org
+  send_client.setCACert(TELEGRAM_CERTIFICATE_ROOT);
+  bot.setSendClient(send_client);
+  botSenderBegin(&bot);
+  bot.longPoll = BOT_LONG_POLL;
+  bot.setBatchSize(BOT_BATCH);
   while (WiFi.status() != WL_CONNECTED)
   {
     Serial.print(".");
@@ -528,20 +851,33 @@ void setup()
   Serial.print("Retrieving time: ");
   configTime(0, 0, "pool.ntp.org"); // get UTC time via NTP
   time_t now = time(nullptr);
+  unsigned long clockWait = millis();
+  while (now < CLOCK_VALID && millis() - clockWait < CLOCK_WAIT)
+  {
+    delay(100);
+    now = time(nullptr);
+  }
   
   Serial.println(now);
 
-  pref.begin("temp", false);
-  tempH  = pref.getFloat("tempH",  22.0);
-  tempHH = pref.getFloat("tempHH", 23.0);
-  tempL  = pref.getFloat("tempL",  18.0);
-  tempLL = pref.getFloat("tempLL", 17.0);
-  selectedMode = pref.getULong("selMode", COOLING);
+  historyBegin();
+  statsBegin();
+  if (!LittleFS.begin(true) || !fermentLogBegin(LittleFS))
+  {
+    Serial.println("LittleFS unavailable, fermentation log disabled");
+  }
+  else
+  {
+    if (now > CLOCK_VALID) restoreHistory(now / 60);
+    historySetSink(fermentLogSink, NULL);
+  }
 
   xTaskCreate(vReadTempTask,         "readTemp",    0x2000, NULL, 2, NULL);
   vTaskDelay(1000);
   xTaskCreate(vCheckNewMessagesTask, "checkMsg",    0x2000, NULL, 2, NULL);
-  xTaskCreate(vTempControl,          "tempControl", 0x2000, NULL, 2, NULL);
+  xTaskCreate(vBotSenderTask,        "botSend",     0x2000, NULL, 2, NULL);
+  xTaskCreate(vTempControl,          "tempControl", 0x2000, NULL, 2, &tempControlHandle);
+  xTaskCreate(vProbeScanTask,        "probeScan",   0x2000, NULL, 1, NULL);
 }
 
 void loop()
@@ -0,0 +1,116 @@
+#include "pidControl.h"
+#include <math.h>
+
+void pidInit(pidLoop_t* pid, float kp, float ki, float kd, float outMin, float outMax)
+{
+  pid->kp     = kp;
+  pid->ki     = ki;
+  pid->kd     = kd;
+  pid->outMin = outMin;
+  pid->outMax = outMax;
+  pidReset(pid);
+}
+
+void pidReset(pidLoop_t* pid)
+{
+  pid->integral = 0;
+  pid->lastPv   = 0;
+  pid->primed   = false;
+}
+
+float pidUpdate(pidLoop_t* pid, float setpoint, float pv, float dt)
+{
+  float error = setpoint - pv;
+  float deriv = 0;
+  float out, integral;
+
+  if (pid->primed && dt > 0) deriv = -(pv - pid->lastPv) / dt;
+  pid->lastPv = pv;
+  pid->primed = true;
+
+  integral = pid->integral + pid->ki * error * dt;
+  out = pid->kp * error + integral + pid->kd * deriv;
+
+  /* anti windup: keep the integral unless it pushes further into the limit */
+  if (out > pid->outMax)
+  {
+    if (error < 0) pid->integral = integral;
+    out = pid->outMax;
+  }
+  else if (out < pid->outMin)
+  {
+    if (error > 0) pid->integral = integral;
+    out = pid->outMin;
+  }
+  else
+  {
+    pid->integral = integral;
+  }
+  return out;
+}
+
+void tpoInit(tpo_t* tpo, unsigned long period, unsigned long minOn, float deadband,
+             unsigned long lockout)
+{
+  tpo->period   = period;
+  tpo->minOn    = minOn;
+  tpo->deadband = deadband;
+  tpo->lockout  = lockout;
+  tpo->start    = 0;
+  tpo->onMs     = 0;
+  tpo->dir      = 0;
+  tpo->lastDir  = 0;
+  tpo->lastEnd  = 0;
+  tpo->started  = false;
+}
+
+int8_t tpoUpdate(tpo_t* tpo, float duty, unsigned long now)
+{
+  if (!tpo->started || now - tpo->start >= tpo->period)
+  {
+    if (tpo->started && tpo->dir != 0)
+    {
+      tpo->lastDir = tpo->dir;
+      tpo->lastEnd = tpo->start + tpo->onMs;
+    }
+    tpo->start   = now;
+    tpo->started = true;
+    tpo->onMs    = fabsf(duty) < tpo->deadband ? 0 : fabsf(duty) * tpo->period;
+    tpo->dir     = duty > 0 ? 1 : -1;
+    if (tpo->onMs < tpo->minOn) tpo->onMs = 0;
+    /* reversing: the other direction must have been off long enough */
+    if (tpo->lastDir != 0 && tpo->dir != tpo->lastDir && now - tpo->lastEnd < tpo->lockout)
+    {
+      tpo->onMs = 0;
+    }
+    if (tpo->onMs == 0) tpo->dir = 0;
+  }
+  return now - tpo->start < tpo->onMs ? tpo->dir : 0;
+}
+
+void cascadeInit(cascade_t* c)
+{
+  pidInit(&c->outer, PID_OUTER_KP, PID_OUTER_KI, 0, -PID_OUTER_SPAN, PID_OUTER_SPAN);
+  pidInit(&c->inner, PID_INNER_KP, PID_INNER_KI, PID_INNER_KD, -1, 1);
+  tpoInit(&c->out, PID_PERIOD, PID_MIN_ON, PID_DEADBAND, PID_LOCKOUT);
+  c->chamberSp = 0;
+  c->duty      = 0;
+}
+
+float cascadeUpdate(cascade_t* c, float liquidSp, float liquid, float chamber, float dt)
+{
+  float held = c->inner.integral;
+
+  c->chamberSp = liquidSp + pidUpdate(&c->outer, liquidSp, liquid, dt);
+  c->duty      = pidUpdate(&c->inner, c->chamberSp, chamber, dt);
+  /* the air overshoots a little after every window: heat only while the
+   * liquid is cold and cool only while it's warm. The inner integral
+   * waits too, or it would wind up against a duty nobody applies */
+  if ((c->duty > 0 && liquid > liquidSp - PID_OUTER_BAND) ||
+      (c->duty < 0 && liquid < liquidSp + PID_OUTER_BAND))
+  {
+    c->duty           = 0;
+    c->inner.integral = held;
+  }
+  return c->duty;
+}
@@ -0,0 +1,216 @@
+#include "probeScan.h"
+#include "sensorReadings.h"
+
+/* slots[] holds the ROMs seen, roleSlot[] the slot of each role so the
+ * role of a probe and the probe of a role are both found in O(1). Both
+ * are guarded by lock; the chamber table addresses are only written with
+ * the bus held too, the reader uses them under the bus lock.
+ */
+static probeSlot_t       slots[PROBE_SLOTS];
+static int8_t            roleSlot[PROBE_ROLES];  /* -1: not seen */
+static bool              seen[PROBE_SLOTS];      /* during this pass */
+static Preferences       pref;
+static SemaphoreHandle_t lock = NULL;
+
+static const char* const probeNames[SAMPLE_PROBES] = { "chamber", "liquid" };
+
+static uint8_t roleCount(void)
+{
+  return numChambers * SAMPLE_PROBES;
+}
+
+static uint8_t* roleAddress(uint8_t role)
+{
+  return chambers[role / SAMPLE_PROBES].probe[role % SAMPLE_PROBES];
+}
+
+static void printProbe(const uint8_t* rom, const char* what, uint8_t role)
+{
+  for (uint8_t i = 0; i < 8; i++) Serial.printf("%02X ", rom[i]);
+  if (role == PROBE_NO_ROLE) Serial.printf("%s\n", what);
+  else Serial.printf("%s, chamber %u %s\n", what, role / SAMPLE_PROBES + 1,
+                     probeNames[role % SAMPLE_PROBES]);
+}
+
+void probeScanBegin(void)
+{
+  char key[8];
+
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+  for (uint8_t r = 0; r < PROBE_ROLES; r++) roleSlot[r] = -1;
+
+  pref.begin("probes", false);
+  for (uint8_t r = 0; r < roleCount(); r++)
+  {
+    snprintf(key, sizeof(key), "role%u", r);
+    if (pref.getBytesLength(key) == 8) pref.getBytes(key, roleAddress(r), 8);
+  }
+}
+
+static bool gone(const probeSlot_t* s)
+{
+  return s->missed >= PROBE_MISS_LIMIT;
+}
+
+static void assignLocked(uint8_t slot, uint8_t role)
+{
+  static const uint8_t none[8] = { 0 };
+  probeSlot_t* s = &slots[slot];
+  char key[8];
+
+  /* a probe moved to another role leaves the old one without a probe */
+  if (s->role != PROBE_NO_ROLE && s->role != role)
+  {
+    roleSlot[s->role] = -1;
+    dsBusTake();
+    memcpy(roleAddress(s->role), none, 8);
+    dsBusGive();
+    snprintf(key, sizeof(key), "role%u", s->role);
+    pref.putBytes(key, none, 8);
+  }
+  if (roleSlot[role] >= 0 && roleSlot[role] != slot) slots[roleSlot[role]].role = PROBE_NO_ROLE;
+
+  s->role = role;
+  roleSlot[role] = slot;
+  dsBusTake();
+  memcpy(roleAddress(role), s->rom, 8);
+  dsBusGive();
+  snprintf(key, sizeof(key), "role%u", role);
+  pref.putBytes(key, s->rom, 8);
+  printProbe(s->rom, "assigned", role);
+}
+
+/* slot for a ROM not in the table: an empty one, else one gone without
+ * a role. Gone probes with a role are kept, they tell which role lost
+ * its probe. */
+static int8_t freeSlot(void)
+{
+  int8_t found = -1;
+
+  for (uint8_t i = 0; i < PROBE_SLOTS; i++)
+  {
+    if (!slots[i].used) return i;
+    if (found < 0 && gone(&slots[i]) && slots[i].role == PROBE_NO_ROLE) found = i;
+  }
+  return found;
+}
+
+static void probeSeen(const uint8_t* rom)
+{
+  int8_t i = -1;
+  probeSlot_t* s;
+
+  for (uint8_t k = 0; k < PROBE_SLOTS && i < 0; k++)
+  {
+    if (slots[k].used && memcmp(slots[k].rom, rom, 8) == 0) i = k;
+  }
+
+  if (i < 0)
+  {
+    i = freeSlot();
+    if (i < 0) return;  /* table full */
+    s = &slots[i];
+    memcpy(s->rom, rom, 8);
+    s->used = true;
+    s->role = PROBE_NO_ROLE;
+    for (uint8_t r = 0; r < roleCount(); r++)
+    {
+      if (memcmp(roleAddress(r), rom, 8) == 0)
+      {
+        s->role = r;
+        roleSlot[r] = i;
+      }
+    }
+    printProbe(rom, "found", s->role);
+  }
+  else if (gone(&slots[i]))
+  {
+    printProbe(rom, "back", slots[i].role);
+  }
+  slots[i].missed = 0;
+  seen[i] = true;
+}
+
+/* one role without its probe and one probe without a role: a swap */
+static void autoAssign(void)
+{
+  int8_t  slot = -1, role = -1;
+  uint8_t orphans = 0, strays = 0;
+
+  for (uint8_t r = 0; r < roleCount(); r++)
+  {
+    if (roleSlot[r] < 0 || gone(&slots[roleSlot[r]]))
+    {
+      role = r;
+      orphans++;
+    }
+  }
+  for (uint8_t i = 0; i < PROBE_SLOTS; i++)
+  {
+    if (slots[i].used && !gone(&slots[i]) && slots[i].role == PROBE_NO_ROLE)
+    {
+      slot = i;
+      strays++;
+    }
+  }
+  if (orphans == 1 && strays == 1) assignLocked(slot, role);
+}
+
+static void endPass(void)
+{
+  for (uint8_t i = 0; i < PROBE_SLOTS; i++)
+  {
+    if (slots[i].used && !seen[i] && slots[i].missed < 0xFF)
+    {
+      if (++slots[i].missed == PROBE_MISS_LIMIT) printProbe(slots[i].rom, "gone", slots[i].role);
+    }
+    seen[i] = false;
+  }
+  autoAssign();
+}
+
+void probeScanList(probeSlot_t* out)
+{
+  xSemaphoreTake(lock, portMAX_DELAY);
+  memcpy(out, slots, sizeof(slots));
+  xSemaphoreGive(lock);
+}
+
+bool probeAssign(uint8_t slot, uint8_t role)
+{
+  bool ok;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ok = slot < PROBE_SLOTS && slots[slot].used && !gone(&slots[slot]) && role < roleCount();
+  if (ok) assignLocked(slot, role);
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+/* one ROM per PROBE_SCAN_SLICE, a pass every PROBE_SCAN_PERIOD */
+void vProbeScanTask(void* px)
+{
+  TickType_t xLastPass = xTaskGetTickCount();
+  uint8_t rom[8];
+
+  while (1)
+  {
+    while (dsSearchStep(rom))
+    {
+      if (OneWire::crc8(rom, 7) == rom[7])
+      {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        probeSeen(rom);
+        xSemaphoreGive(lock);
+      }
+      vTaskDelay(pdMS_TO_TICKS(PROBE_SCAN_SLICE));
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    endPass();
+    xSemaphoreGive(lock);
+    vTaskDelayUntil(&xLastPass, pdMS_TO_TICKS(PROBE_SCAN_PERIOD));
+  }
+
+  /* Must not exit, but if you leave the while(1) you can delete the task */
+  vTaskDelete(NULL);
+}
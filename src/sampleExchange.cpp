@@ -0,0 +1,79 @@
+#include "sampleExchange.h"
+#include <atomic>
+#include <string.h>
+
+/* Samples rotate over three slots, each guarded by its own sequence
+ * number (seqlock). The writer never touches the latest published slot,
+ * so a reader copying it is only disturbed if two more samples are
+ * published meanwhile, about two conversion cycles. Readers never wait
+ * on the writer and the writer never waits on readers. Every channel
+ * has its own slots.
+ */
+#define SAMPLE_SLOTS (3)
+#define SAMPLE_WORDS (sizeof(tempSample_t) / sizeof(uint32_t))
+
+static_assert(sizeof(tempSample_t) % sizeof(uint32_t) == 0,
+              "tempSample_t must be made of 32 bit words");
+
+typedef struct {
+  std::atomic<uint32_t> words[SAMPLE_SLOTS][SAMPLE_WORDS];
+  std::atomic<uint32_t> seq[SAMPLE_SLOTS];
+  std::atomic<uint32_t> published;
+} channel_t;
+
+static channel_t channels[SAMPLE_CHANNELS];
+
+void publishSample(uint8_t channel, const tempSample_t* sample)
+{
+  channel_t* c = &channels[channel];
+  uint32_t words[SAMPLE_WORDS];
+  uint32_t n    = c->published.load(std::memory_order_relaxed) + 1;
+  uint8_t  slot = n % SAMPLE_SLOTS;
+
+  memcpy(words, sample, sizeof(words));
+
+  /* odd sequence: slot being written */
+  c->seq[slot].store(2 * n - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (uint8_t i = 0; i < SAMPLE_WORDS; i++)
+  {
+    c->words[slot][i].store(words[i], std::memory_order_relaxed);
+  }
+  c->seq[slot].store(2 * n, std::memory_order_release);
+  c->published.store(n, std::memory_order_release);
+}
+
+uint32_t readSample(uint8_t channel, tempSample_t* sample)
+{
+  channel_t* c = &channels[channel];
+  uint32_t words[SAMPLE_WORDS];
+  uint32_t n, seq;
+  uint8_t  slot;
+
+  while (1)
+  {
+    n = c->published.load(std::memory_order_acquire);
+    if (n == 0)
+    {
+      memset(sample, 0, sizeof(*sample));
+      return 0;
+    }
+    slot = n % SAMPLE_SLOTS;
+    seq  = c->seq[slot].load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < SAMPLE_WORDS; i++)
+    {
+      words[i] = c->words[slot][i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    /* slot untouched while copying: consistent view */
+    if (seq == 2 * n && c->seq[slot].load(std::memory_order_relaxed) == seq) break;
+  }
+  memcpy(sample, words, sizeof(words));
+  return n;
+}
+
+bool sampleIsFresh(const tempSample_t* sample, uint32_t probes, unsigned long now,
+                   unsigned long maxAge)
+{
+  return (sample->valid & probes) == probes && (now - sample->stamp <= maxAge);
+}
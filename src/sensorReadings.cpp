@@ -3,14 +3,40 @@
 // Setup a oneWire instance to communicate with any OneWire devices
 OneWire oneWire(ONE_WIRE_BUS);
 
+#if ONEWIRE_RMT
+// slots clocked by the RMT peripheral once setupSensorsOnOneWire() binds it
+static OneWireRmtChannels rmtChannels(ONE_WIRE_BUS);
+static OneWireRmt         oneWireRmt(&rmtChannels);
+#endif
+
 // Pass our oneWire reference to Dallas Temperature sensor 
 DallasTemperature sensors(&oneWire);
 
+static SemaphoreHandle_t busLock = NULL;
+
+/* The conversion the reader requested last, guarded by busLock. On
+ * parasite power it runs on the strong pull-up the request left on the
+ * bus, and any reset or slot before it ends would starve the probes. */
+static bool          parasiteConverting = false;
+static unsigned long convStart, convTime;
+
+/* dsReaderBoost() calls, only ever incremented there */
+static volatile uint32_t boostRequests = 0;
+
 /* Init one wire for ds18b20 */
 void setupSensorsOnOneWire()
 {
+  if (busLock == NULL) busLock = xSemaphoreCreateMutex();
+#if ONEWIRE_RMT
+  if (rmtChannels.begin()) oneWire.begin(&oneWireRmt);
+  else Serial.println("RMT driver not installed, 1-Wire stays on the CPU");
+#endif
   // Start up the DS18B20 library
   sensors.begin();
+  // conversions are awaited by the reader state machine, not by the library
+  sensors.setWaitForConversion(false);
+  // the reader changes the resolution often, keep the EEPROM out of it
+  sensors.setAutoSaveScratchPad(false);
 }
 
 /* Read a sensor by index. float format */
@@ -18,6 +44,7 @@ float readDSTempC(uint8_t sensorIndex)
 {
   float tempC;
   sensors.requestTemperatures(); 
+  delay(sensors.millisToWaitForConversion(sensors.getResolution()));
   tempC = sensors.getTempCByIndex(sensorIndex);
   return tempC;  
 }
@@ -27,6 +54,7 @@ float readDSTempC(uint8_t* add)
 {
   float tempC;
   sensors.requestTemperaturesByAddress(add); 
+  delay(sensors.millisToWaitForConversion(sensors.getResolution(add)));
   tempC = sensors.getTempC(add);
   return tempC; 
 }
@@ -68,6 +96,135 @@ String readDSTempStringCByAdd(uint8_t* sensorAdd)
   return tempCString;
 }
 
+/* Bind a reader to probe addresses, their copy and output values */
+void dsReaderInit(dsReader_t* r, uint8_t** addrs, DeviceAddress* roms,
+                  int16_t* raws, uint8_t count, unsigned long fastMs,
+                  unsigned long slowMs)
+{
+  r->state      = DS_READ_IDLE;
+  r->count      = count < DS_READER_PROBES ? count : DS_READER_PROBES;
+  r->addrs      = addrs;
+  r->roms       = roms;
+  r->raws       = raws;
+  r->started    = 0;
+  r->convMs     = 0;
+  r->fastMs     = fastMs;
+  r->slowMs     = slowMs;
+  r->resolution = DS_RES_SLOW;
+  r->boosted    = false;
+  r->boostStart = 0;
+  r->boostsSeen = boostRequests;
+  r->refTaken   = false;
+  r->refStamp   = 0;
+}
+
+void dsReaderBoost(void)
+{
+  boostRequests = boostRequests + 1;
+}
+
+/* Fast after a relay switched or while a probe moves, see DS_BOOST_MS */
+static void dsReaderAdapt(dsReader_t* r, unsigned long now)
+{
+  uint32_t requests = boostRequests;
+  int16_t  delta = 0, d;
+
+  if (requests != r->boostsSeen)
+  {
+    r->boostsSeen = requests;
+    r->boosted    = true;
+    r->boostStart = now;
+  }
+
+  if (!r->refTaken || now - r->refStamp >= DS_SLOPE_WINDOW)
+  {
+    for (uint8_t i = 0; r->refTaken && i < r->count; i++)
+    {
+      if (r->raws[i] == DEVICE_DISCONNECTED_RAW || r->ref[i] == DEVICE_DISCONNECTED_RAW) continue;
+      d = abs(r->raws[i] - r->ref[i]);
+      if (d > delta) delta = d;
+    }
+    if (delta >= DS_FAST_DELTA)
+    {
+      r->boosted    = true;
+      r->boostStart = now;
+    }
+    memcpy(r->ref, r->raws, r->count * sizeof(int16_t));
+    r->refTaken = true;
+    r->refStamp = now;
+  }
+
+  if (r->boosted && now - r->boostStart >= DS_BOOST_MS) r->boosted = false;
+}
+
+/* Ask every probe for the reader's resolution. Only probes whose cached
+ * resolution differs touch the bus. Returns the highest resolution left
+ * on a probe, the one the conversion must be waited for.
+ */
+static uint8_t dsReaderResolution(dsReader_t* r)
+{
+  uint8_t highest = r->resolution, res;
+
+  for (uint8_t i = 0; i < r->count; i++)
+  {
+    if (!sensors.validFamily(r->roms[i])) continue;
+    res = sensors.getResolution(r->roms[i]);
+    if (res != r->resolution && sensors.setResolution(r->roms[i], r->resolution, true))
+    {
+      res = r->resolution;
+    }
+    if (res > highest) highest = res;
+  }
+  return highest;
+}
+
+/* Advance the reader. One skip-ROM convert T is shared by every probe,
+ * so a sample costs one conversion time whatever the number of probes.
+ * The next conversion is requested right after collecting, the probes
+ * convert while the caller sleeps.
+ */
+bool dsReaderStep(dsReader_t* r, unsigned long now, unsigned long* waitMs)
+{
+  bool fresh = false;
+  unsigned long period;
+  uint8_t res;
+
+  if (r->state == DS_READ_CONVERTING) {
+    if (now - r->started < r->convMs) {
+      *waitMs = r->convMs - (now - r->started);
+      return false;
+    }
+    r->state = DS_READ_COLLECT;
+  }
+
+  dsBusTake();
+  /* the probe scan rewrites addrs with the bus held */
+  for (uint8_t i = 0; i < r->count; i++) memcpy(r->roms[i], r->addrs[i], 8);
+  if (r->state == DS_READ_COLLECT) {
+    sensors.readAll(r->roms, r->count, r->raws);
+    dsReaderAdapt(r, now);
+    fresh = true;
+  }
+  if ((r->boosted ? DS_RES_FAST : DS_RES_SLOW) != r->resolution) {
+    r->resolution = r->boosted ? DS_RES_FAST : DS_RES_SLOW;
+    Serial.printf("Sampling at %u bits\n", r->resolution);
+  }
+
+  res        = dsReaderResolution(r);
+  sensors.requestTemperatures();
+  r->started = now;
+  r->convMs  = sensors.millisToWaitForConversion(res);
+  r->state   = DS_READ_CONVERTING;
+  parasiteConverting = sensors.isParasitePowerMode();
+  convStart  = now;
+  convTime   = r->convMs;
+  dsBusGive();
+  period     = r->boosted ? r->fastMs : r->slowMs;
+  *waitMs    = r->convMs > period ? r->convMs : period;
+
+  return fresh;
+}
+
 int getSensorCount()
 {
   return sensors.getDeviceCount();
@@ -76,4 +233,32 @@ int getSensorCount()
 bool getAddress(DeviceAddress addr, int i)
 {
   return sensors.getAddress(addr, i);
-}
\ No newline at end of file
+}
+
+void dsBusTake(void)
+{
+  xSemaphoreTake(busLock, portMAX_DELAY);
+}
+
+void dsBusGive(void)
+{
+  xSemaphoreGive(busLock);
+}
+
+bool dsSearchStep(uint8_t* rom)
+{
+  unsigned long elapsed;
+  bool found;
+
+  dsBusTake();
+  while (parasiteConverting && (elapsed = millis() - convStart) < convTime)
+  {
+    dsBusGive();
+    vTaskDelay(pdMS_TO_TICKS(convTime - elapsed));
+    dsBusTake();
+  }
+  found = oneWire.search(rom);
+  if (!found) oneWire.reset_search();
+  dsBusGive();
+  return found;
+}
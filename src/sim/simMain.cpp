@@ -0,0 +1,203 @@
+/* Control benchmark: runs controlStep() against the thermal plant in
+ * simulated time and reports, per scenario and per simulated day, how
+ * well the liquid was held and what it cost in relay wear and energy.
+ *
+ *   sim [days] [scenario ...]
+ *
+ * Build it with "pio run -e sim", or by hand:
+ *   g++ -O2 -Iinclude src/sim/thermalPlant.cpp src/sim/simMain.cpp \
+ *       src/tempControl.cpp src/pidControl.cpp src/sampleExchange.cpp -o sim
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "tempControl.h"
+#include "thermalPlant.h"
+
+#define SIM_DAYS        (7)
+#define SIM_STEP        (1000)     /* ms per plant step, one sample each */
+#define SIM_SHORT_CYCLE (300000)   /* compressor runs or rests shorter than this, ms */
+#define SIM_RESOLUTION  (0.0625)   /* DS18B20 at 12 bits */
+#define SIM_NOISE       (0.03)     /* probe noise, °C peak */
+
+typedef struct {
+  const char *name;
+  uint8_t     mode;
+  float       start;               /* every temperature at t = 0 */
+  float       roomMean, roomSwing;
+  float       fermentPeak;
+  float       tempH, tempHH, tempL, tempLL;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+  /* ale fermenting in a warm room */
+  { "auto",     MODE_AUTO, 24, 24, 4, 12, 20, 21, 18, 17 },
+  { "cool",     MODE_COOL, 24, 24, 4, 12, 20, 21, 18, 17 },
+  { "pid",      MODE_PID,  24, 24, 4, 12, 20, 21, 18, 17 },
+  /* the same batch in a cold garage */
+  { "heat",     MODE_HEAT, 12, 12, 4, 12, 20, 21, 18, 17 },
+  { "pid-cold", MODE_PID,  12, 12, 4, 12, 20, 21, 18, 17 },
+  /* lager */
+  { "lager",    MODE_COOL, 20, 22, 3, 8,  11, 12, 9,  8 },
+  { "pid-lager",MODE_PID,  20, 22, 3, 8,  11, 12, 9,  8 },
+};
+#define NUM_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct {
+  double   overshoot;      /* liquid above tempH after settling, °C */
+  double   undershoot;     /* liquid below tempL after settling, °C */
+  double   rms;            /* liquid vs the middle of the band, °C */
+  double   inBand;         /* fraction of the settled time within the band */
+  double   settleHours;    /* until the liquid first entered the band */
+  uint32_t cycles[PLANT_RELAYS];
+  uint32_t shortCycles;
+  double   kwh[PLANT_RELAYS];
+} simReport_t;
+
+static uint32_t noiseSeed = 1;
+
+/* what a probe reports: noisy and rounded to the DS18B20 resolution */
+static float probe(float t)
+{
+  noiseSeed = noiseSeed * 1103515245 + 12345;
+  t += SIM_NOISE * (((noiseSeed >> 16) & 0x7FFF) / 16383.5 - 1);
+  return roundf(t / SIM_RESOLUTION) * SIM_RESOLUTION;
+}
+
+static void runScenario(const scenario_t *sc, uint32_t days, simReport_t *r)
+{
+  plantParams_t  params;
+  plantState_t   plant;
+  ctrlState_t    ctrl;
+  ctrlSettings_t set;
+  tempSample_t   sample;
+  uint32_t       now, end = days * 86400000UL;
+  uint32_t       coolOn = 0, coolOff = 0, settled = 0, samples = 0, inBand = 0;
+  uint8_t        relays = 0, last = 0;
+  bool           isSettled = false, coolRan = false;
+  double         sq = 0, mid = (sc->tempH + sc->tempL) / 2.0;
+
+  plantDefaults(&params);
+  params.roomMean    = sc->roomMean;
+  params.roomSwing   = sc->roomSwing;
+  params.fermentPeak = sc->fermentPeak;
+  plantInit(&plant, sc->start);
+
+  set.selectedMode = sc->mode;
+  set.tempH  = sc->tempH;
+  set.tempHH = sc->tempHH;
+  set.tempL  = sc->tempL;
+  set.tempLL = sc->tempLL;
+  controlInit(&ctrl, 0);
+  memset(r, 0, sizeof(*r));
+  noiseSeed = 1;
+
+  for (now = 0; now < end; now += SIM_STEP)
+  {
+    sample.temp[PROBE_CHAMBER] = probe(plant.air);
+    sample.temp[PROBE_LIQUID]  = probe(plant.liquid);
+    sample.stamp = now;
+    sample.valid = SAMPLE_ALL;
+    controlStep(&ctrl, &set, &sample, now);
+
+    relays = (ctrl.blowing ? 1 << PLANT_FAN  : 0) |
+             (ctrl.cooling ? 1 << PLANT_COOL : 0) |
+             (ctrl.heating ? 1 << PLANT_HEAT : 0);
+    for (uint8_t i = 0; i < PLANT_RELAYS; i++)
+    {
+      if ((relays & ~last) & (1 << i)) r->cycles[i]++;
+    }
+    /* compressor runs and rests */
+    if ((relays & ~last) & (1 << PLANT_COOL))
+    {
+      if (coolRan && now - coolOff < SIM_SHORT_CYCLE) r->shortCycles++;
+      coolOn = now;
+    }
+    if ((last & ~relays) & (1 << PLANT_COOL))
+    {
+      if (now - coolOn < SIM_SHORT_CYCLE) r->shortCycles++;
+      coolOff = now;
+      coolRan = true;
+    }
+    last = relays;
+
+    plantStep(&plant, &params, relays, now / 1000.0, SIM_STEP / 1000.0);
+
+    if (!isSettled && plant.liquid <= sc->tempH && plant.liquid >= sc->tempL)
+    {
+      isSettled = true;
+      settled   = now;
+    }
+    if (isSettled)
+    {
+      if (plant.liquid - sc->tempH > r->overshoot)  r->overshoot  = plant.liquid - sc->tempH;
+      if (sc->tempL - plant.liquid > r->undershoot) r->undershoot = sc->tempL - plant.liquid;
+      if (plant.liquid <= sc->tempH && plant.liquid >= sc->tempL) inBand++;
+      sq += (plant.liquid - mid) * (plant.liquid - mid);
+      samples++;
+    }
+  }
+
+  r->settleHours = (isSettled ? settled : end) / 3600000.0;
+  r->rms    = samples ? sqrt(sq / samples) : NAN;
+  r->inBand = samples ? (double)inBand / samples : 0;
+  for (uint8_t i = 0; i < PLANT_RELAYS; i++)
+  {
+    r->kwh[i] = plant.energy[i] / 3.6e6;
+  }
+}
+
+static void printReport(const scenario_t *sc, uint32_t days, const simReport_t *r)
+{
+  printf("%-10s %6.1f %6.2f %6.2f %6.3f %6.1f%% %6.1f %6.1f %6.1f %6.1f %7.3f %7.3f\n",
+         sc->name, r->settleHours, r->overshoot, r->undershoot, r->rms, 100 * r->inBand,
+         (double)r->cycles[PLANT_FAN] / days, (double)r->cycles[PLANT_COOL] / days,
+         (double)r->cycles[PLANT_HEAT] / days, (double)r->shortCycles / days,
+         (r->kwh[PLANT_COOL] + r->kwh[PLANT_FAN]) / days, r->kwh[PLANT_HEAT] / days);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t    days = SIM_DAYS;
+  simReport_t report;
+  clock_t     started;
+  double      seconds, simulated = 0;
+  int         first = 1, run = 0;
+
+  if (argc > 1 && atoi(argv[1]) > 0)
+  {
+    days  = atoi(argv[1]);
+    first = 2;
+  }
+  if (days > 49) days = 49;  /* ms stamps wrap after 49.7 days */
+
+  printf("%u simulated days per scenario, liquid figures after settling, counts per day\n", days);
+  printf("%-10s %6s %6s %6s %6s %7s %6s %6s %6s %6s %7s %7s\n",
+         "scenario", "settle", "over", "under", "rms", "band", "fan", "cool", "heat", "short",
+         "kWh c", "kWh h");
+  started = clock();
+  for (size_t i = 0; i < NUM_SCENARIOS; i++)
+  {
+    bool wanted = argc <= first;
+    for (int a = first; a < argc; a++)
+    {
+      if (strcmp(argv[a], scenarios[i].name) == 0) wanted = true;
+    }
+    if (!wanted) continue;
+    runScenario(&scenarios[i], days, &report);
+    printReport(&scenarios[i], days, &report);
+    simulated += days * 86400.0;
+    run++;
+  }
+  seconds = (double)(clock() - started) / CLOCKS_PER_SEC;
+  if (run == 0)
+  {
+    fprintf(stderr, "unknown scenario\n");
+    return 1;
+  }
+  printf("%.0f simulated hours in %.2f s, %.0fx real time\n",
+         simulated / 3600, seconds, seconds > 0 ? simulated / seconds : INFINITY);
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include "thermalPlant.h"
+#include <math.h>
+
+void plantDefaults(plantParams_t* p)
+{
+  p->cAir              = 4000;     /* air plus liner */
+  p->cEvap             = 1500;
+  p->cLiquid           = 88000;    /* 20 l of wort and the fermenter */
+  p->uaRoom            = 1.2;
+  p->uaEvapFan         = 12;
+  p->uaEvapStill       = 4;
+  p->uaLiquidFan       = 5;
+  p->uaLiquidStill     = 3;
+  p->coolPower         = 90;
+  p->heatPower         = 60;
+  p->fanPower          = 4;
+  p->elecPower[PLANT_FAN]  = 4;
+  p->elecPower[PLANT_COOL] = 70;
+  p->elecPower[PLANT_HEAT] = 60;
+  p->roomMean          = 24;
+  p->roomSwing         = 4;
+  p->fermentPeak       = 12;
+  p->fermentPeakHours  = 36;
+  p->fermentWidthHours = 18;
+}
+
+void plantInit(plantState_t* s, float start)
+{
+  s->air    = start;
+  s->evap   = start;
+  s->liquid = start;
+  for (uint8_t i = 0; i < PLANT_RELAYS; i++) s->energy[i] = 0;
+}
+
+/* coolest at 6 am, warmest at 6 pm */
+float plantRoom(const plantParams_t* p, double t)
+{
+  return p->roomMean - p->roomSwing * cos(2 * M_PI * (t - 6 * 3600) / 86400);
+}
+
+static float fermentHeat(const plantParams_t* p, double t)
+{
+  double x = (t / 3600 - p->fermentPeakHours) / p->fermentWidthHours;
+  return p->fermentPeak * exp(-x * x / 2);
+}
+
+/* explicit Euler, the fastest time constant (evaporator, ~2 min) is far
+ * longer than the 1 s steps the simulator takes
+ */
+void plantStep(plantState_t* s, const plantParams_t* p, uint8_t relays, double t, float dt)
+{
+  bool  fan  = relays & (1 << PLANT_FAN);
+  bool  cool = relays & (1 << PLANT_COOL);
+  bool  heat = relays & (1 << PLANT_HEAT);
+  float uaEvap   = fan ? p->uaEvapFan : p->uaEvapStill;
+  float uaLiquid = fan ? p->uaLiquidFan : p->uaLiquidStill;
+  float qEvap    = uaEvap * (s->evap - s->air);
+  float qLiquid  = uaLiquid * (s->liquid - s->air);
+  float qRoom    = p->uaRoom * (plantRoom(p, t) - s->air);
+  float qAir     = qEvap + qLiquid + qRoom;
+
+  if (fan)  qAir += p->fanPower;
+  if (heat) qAir += p->heatPower;
+
+  s->air    += qAir * dt / p->cAir;
+  s->evap   += (-qEvap - (cool ? p->coolPower : 0)) * dt / p->cEvap;
+  s->liquid += (fermentHeat(p, t) - qLiquid) * dt / p->cLiquid;
+
+  for (uint8_t i = 0; i < PLANT_RELAYS; i++)
+  {
+    if (relays & (1 << i)) s->energy[i] += p->elecPower[i] * dt;
+  }
+}
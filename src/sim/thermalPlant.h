@@ -0,0 +1,45 @@
+#ifndef THERMAL_PLANT_H
+#define THERMAL_PLANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Lumped model of a fermentation chamber: chamber air (with the liner),
+ * the evaporator plate and the liquid, each one heat capacity, joined by
+ * conductances that grow while the fan blows. The room follows a daily
+ * sine and the yeast adds a bell shaped heat release. Units are SI: J/K,
+ * W/K, W, seconds and °C.
+ */
+
+#define PLANT_FAN  (0)
+#define PLANT_COOL (1)
+#define PLANT_HEAT (2)
+#define PLANT_RELAYS (3)
+
+typedef struct {
+  float cAir, cEvap, cLiquid;         /* heat capacities */
+  float uaRoom;                       /* chamber <-> room */
+  float uaEvapFan, uaEvapStill;       /* evaporator <-> air */
+  float uaLiquidFan, uaLiquidStill;   /* liquid <-> air */
+  float coolPower;                    /* heat pulled from the evaporator */
+  float heatPower;                    /* heater, into the air */
+  float fanPower;                     /* fan motor, into the air */
+  float elecPower[PLANT_RELAYS];      /* electrical draw per relay */
+  float roomMean, roomSwing;          /* room temperature, daily sine */
+  float fermentPeak;                  /* W released at the peak */
+  float fermentPeakHours, fermentWidthHours;
+} plantParams_t;
+
+typedef struct {
+  float  air, evap, liquid;
+  double energy[PLANT_RELAYS];        /* J drawn per relay */
+} plantState_t;
+
+/* A 20 l batch in a small fridge with a heating belt */
+void  plantDefaults(plantParams_t*);
+void  plantInit(plantState_t*, float start);
+float plantRoom(const plantParams_t*, double t);
+/* Advance dt seconds from time t with the relays given by PLANT_* bits */
+void  plantStep(plantState_t*, const plantParams_t*, uint8_t relays, double t, float dt);
+
+#endif /* !THERMAL_PLANT_H */
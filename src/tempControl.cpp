@@ -0,0 +1,224 @@
+#include "tempControl.h"
+
+void controlInit(ctrlState_t* st, uint32_t now)
+{
+  st->currentMode = UNDEFINED;
+  st->cooling     = false;
+  st->heating     = false;
+  st->blowing     = false;
+  st->canRestart  = false;
+  st->canStopFan  = false;
+  st->timeOff     = now;
+  st->pidActive   = false;
+  st->pidStamp    = 0;
+}
+
+/* heating or cooling stopped: the compressor and fan timers start over */
+static void stopRelays(ctrlState_t* st, uint32_t now)
+{
+  st->timeOff = now;
+  st->cooling = false;
+  st->heating = false;
+}
+
+static void stepPid(ctrlState_t* st, const ctrlSettings_t* set, const tempSample_t* sample,
+                    uint32_t now)
+{
+  int8_t pidOut;
+
+  /* the liquid is driven to the middle of the hysteresis band */
+  if (!st->pidActive)
+  {
+    cascadeInit(&st->cascade);
+    st->pidActive = true;
+    st->pidStamp  = sample->stamp;
+  }
+  if (sample->stamp != st->pidStamp)
+  {
+    cascadeUpdate(&st->cascade, (set->tempH + set->tempL) / 2, sample->temp[PROBE_LIQUID],
+                  sample->temp[PROBE_CHAMBER], (sample->stamp - st->pidStamp) / 1000.0);
+    st->pidStamp = sample->stamp;
+  }
+  pidOut = tpoUpdate(&st->cascade.out, st->cascade.duty, now);
+  /* the mode of the window, an idle one neither heats nor cools */
+  if (st->cascade.out.dir < 0) st->currentMode = COOLING;
+  else if (st->cascade.out.dir > 0) st->currentMode = HEATING;
+  else st->currentMode = UNDEFINED;
+
+  if ((st->cooling && pidOut >= 0) || (st->heating && pidOut <= 0))
+  {
+    stopRelays(st, now);
+  }
+  /* the compressor keeps its minimum off time, the window is cut short */
+  if (pidOut < 0 && !st->cooling && st->canRestart)
+  {
+    st->cooling = true;
+    st->blowing = true;
+  }
+  if (pidOut > 0 && !st->heating)
+  {
+    st->heating = true;
+    st->blowing = true;
+  }
+  if (!st->cooling && !st->heating && st->blowing && st->canStopFan)
+  {
+    st->blowing = false;
+  }
+}
+
+static void stepHysteresis(ctrlState_t* st, ctrlSettings_t* set, float refTemp, uint32_t now)
+{
+  /* mode changes */
+  switch (set->selectedMode)
+  {
+    case MODE_AUTO :
+      switch (st->currentMode)
+      {
+        case UNDEFINED :
+          if (refTemp > set->tempHH) st->currentMode = COOLING;
+          else if (refTemp < set->tempLL) st->currentMode = HEATING;
+          break;
+        case HEATING :
+          if (refTemp > set->tempHH) st->currentMode = COOLING;
+          break;
+        case COOLING :
+          if (refTemp < set->tempLL) st->currentMode = HEATING;
+          break;
+        default:
+          st->currentMode = UNDEFINED;
+      }
+      break;
+    case MODE_COOL :
+      st->currentMode = COOLING;
+      break;
+    case MODE_HEAT :
+      st->currentMode = HEATING;
+      break;
+    default:
+      st->currentMode   = UNDEFINED;
+      set->selectedMode = MODE_OFF;
+  }
+  /* temp control */
+  switch (st->currentMode)
+  {
+    case UNDEFINED :
+      st->cooling = false;
+      st->heating = false;
+      if (st->blowing && st->canStopFan)
+      {
+        st->blowing = false;
+      }
+      break;
+    case COOLING :
+      if (st->heating)
+      {
+        st->timeOff = now;
+        st->heating = false;
+      }
+      if (st->cooling && (refTemp < set->tempL))
+      {
+        st->timeOff = now;
+        st->cooling = false;
+      }
+      else if (!(st->cooling))
+      {
+        if (st->canRestart && (refTemp > set->tempH))
+        {
+          st->cooling = true;
+          st->blowing = true;
+        }
+        else if (st->blowing && st->canStopFan)
+        {
+          st->blowing = false;
+        }
+      }
+      break;
+    case HEATING :
+      if (st->cooling)
+      {
+        st->timeOff = now;
+        st->cooling = false;
+      }
+      if (st->heating && (refTemp > set->tempH))
+      {
+        st->timeOff = now;
+        st->heating = false;
+      }
+      else if (!(st->heating))
+      {
+        if (refTemp < set->tempL)
+        {
+          st->heating = true;
+          st->blowing = true;
+        }
+        else if (st->blowing && st->canStopFan)
+        {
+          st->blowing = false;
+        }
+      }
+      break;
+    default:
+      st->currentMode = UNDEFINED;
+  }
+}
+
+void controlStep(ctrlState_t* st, ctrlSettings_t* set, tempSample_t* sample, uint32_t now)
+{
+  uint32_t needed;
+  bool     usable;
+
+  if (now < st->timeOff) st->timeOff = now;
+  st->canRestart = now - st->timeOff > COOL_WAIT;
+  st->canStopFan = now - st->timeOff > FAN_WAIT;
+
+  if (!sampleIsFresh(sample, 0, now, SAMPLE_MAX_AGE)) sample->valid = 0;
+  /* the hysteresis modes follow the chamber probe, MODE_PID both */
+  needed = set->selectedMode == MODE_PID ? SAMPLE_ALL : SAMPLE_VALID(PROBE_CHAMBER);
+  usable = (sample->valid & needed) == needed;
+  if (set->selectedMode != MODE_PID || !usable) st->pidActive = false;
+
+  if (set->selectedMode != MODE_OFF && !usable)
+  {
+    /* no trustworthy reading: stop heating and cooling until one arrives */
+    if (st->cooling || st->heating) stopRelays(st, now);
+    if (st->blowing && st->canStopFan)
+    {
+      st->blowing = false;
+    }
+  }
+  else if (set->selectedMode == MODE_PID)
+  {
+    stepPid(st, set, sample, now);
+  }
+  else if (set->selectedMode != MODE_OFF)
+  {
+    stepHysteresis(st, set, sample->temp[PROBE_CHAMBER], now);
+  }
+  else
+  {
+    st->currentMode = UNDEFINED;
+    if (st->cooling)
+    {
+      st->timeOff = now;
+    }
+    st->cooling = false;
+    st->heating = false;
+    st->blowing = false;
+  }
+}
+
+uint32_t controlTimeout(const ctrlState_t* st, const tempSample_t* sample, uint32_t now)
+{
+  uint32_t wait    = CTRL_WAIT_FOREVER;
+  uint32_t elapsed = now - st->timeOff;
+  uint32_t age;
+
+  if (elapsed <= COOL_WAIT && COOL_WAIT - elapsed + 1 < wait) wait = COOL_WAIT - elapsed + 1;
+  if (elapsed <= FAN_WAIT  && FAN_WAIT  - elapsed + 1 < wait) wait = FAN_WAIT  - elapsed + 1;
+  if (sampleIsFresh(sample, SAMPLE_VALID(PROBE_CHAMBER), now, SAMPLE_MAX_AGE))
+  {
+    age = now - sample->stamp;
+    if (SAMPLE_MAX_AGE - age + 1 < wait) wait = SAMPLE_MAX_AGE - age + 1;
+  }
+  return wait;
+}
@@ -0,0 +1,210 @@
+#include "tempHistory.h"
+
+/* Temperatures are kept in centi degrees. Each entry holds the change
+ * from the previous entry in one byte per probe, and every HISTORY_BLOCK
+ * entries a keyframe holds the absolute values. The delta is taken from
+ * the value the decoder will rebuild, so a step too large for one byte
+ * is caught up over the following entries instead of drifting.
+ * 3 bytes per entry, about 31 KB for a week.
+ */
+#define HISTORY_KEYS (HISTORY_LEN / HISTORY_BLOCK)
+
+static_assert(HISTORY_LEN % HISTORY_BLOCK == 0, "HISTORY_LEN must be made of whole blocks");
+static_assert(HISTORY_LEN - HISTORY_BLOCK >= 7 * 24 * 60, "history must hold a week");
+
+typedef struct {
+  int8_t  delta[SAMPLE_PROBES];
+  uint8_t flags;
+} historyEntry_t;
+
+typedef struct {
+  int16_t temp[SAMPLE_PROBES];
+} historyKey_t;
+
+static historyEntry_t    entries[HISTORY_LEN];
+static historyKey_t      keys[HISTORY_KEYS];
+static int16_t           current[SAMPLE_PROBES];  /* value of the newest entry */
+static uint32_t          head = 0;                /* slot of the next entry */
+static uint32_t          stored = 0;              /* entries written, up to HISTORY_LEN */
+static unsigned long     lastStamp;
+static SemaphoreHandle_t lock = NULL;
+static historySink_t     sink = NULL;
+static void*             sinkArg;
+
+void historyBegin(void)
+{
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+}
+
+void historySetSink(historySink_t fn, void* arg)
+{
+  xSemaphoreTake(lock, portMAX_DELAY);
+  sink    = fn;
+  sinkArg = arg;
+  xSemaphoreGive(lock);
+}
+
+/* hand the newest entry to the sink, caller holds the lock */
+static void emit(uint8_t flags)
+{
+  historyPoint_t point;
+
+  if (sink == NULL) return;
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++) point.temp[p] = current[p] / 100.0;
+  point.flags = flags;
+  sink(&point, lastStamp, sinkArg);
+}
+
+static void append(const int16_t* temp, uint8_t flags)
+{
+  historyEntry_t* e = &entries[head];
+  int32_t d;
+
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+  {
+    if (head % HISTORY_BLOCK == 0)
+    {
+      /* keyframe: start the block from the exact value */
+      if (!(flags & HIST_INVALID(p))) current[p] = temp[p];
+      keys[head / HISTORY_BLOCK].temp[p] = current[p];
+      e->delta[p] = 0;
+      continue;
+    }
+    d = (flags & HIST_INVALID(p)) ? 0 : temp[p] - current[p];
+    d = constrain(d, -128, 127);
+    e->delta[p] = d;
+    current[p] += d;
+  }
+  e->flags = flags;
+
+  head = (head + 1) % HISTORY_LEN;
+  if (stored < HISTORY_LEN) stored++;
+}
+
+void historyRecord(const tempSample_t* sample, uint8_t relays, unsigned long now)
+{
+  static bool started = false;
+  int16_t temp[SAMPLE_PROBES];
+  uint8_t flags = relays & (HIST_FAN | HIST_COOL | HIST_HEAT);
+  uint8_t invalid = 0;
+
+  if (!started)
+  {
+    started = true;
+    lastStamp = now - HISTORY_PERIOD;
+  }
+  if (now - lastStamp < HISTORY_PERIOD) return;
+
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+  {
+    temp[p] = lroundf(sample->temp[p] * 100);
+    invalid |= HIST_INVALID(p);
+    if (!(sample->valid & SAMPLE_VALID(p))) flags |= HIST_INVALID(p);
+  }
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  /* periods nobody recorded, e.g. the task was held up */
+  if (now - lastStamp > (unsigned long)HISTORY_LEN * HISTORY_PERIOD)
+  {
+    lastStamp = now - (unsigned long)HISTORY_LEN * HISTORY_PERIOD;
+  }
+  while (now - lastStamp >= 2 * HISTORY_PERIOD)
+  {
+    lastStamp += HISTORY_PERIOD;
+    append(current, invalid);
+    emit(invalid);
+  }
+  lastStamp += HISTORY_PERIOD;
+  append(temp, flags);
+  emit(flags);
+  xSemaphoreGive(lock);
+}
+
+void historyRestore(const historyPoint_t* point)
+{
+  int16_t temp[SAMPLE_PROBES];
+
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+  {
+    temp[p] = lroundf(point->temp[p] * 100);
+  }
+  xSemaphoreTake(lock, portMAX_DELAY);
+  append(temp, point->flags);
+  xSemaphoreGive(lock);
+}
+
+/* entries are readable from the first keyframe after the block being
+ * overwritten */
+static uint32_t readable(void)
+{
+  if (stored < HISTORY_LEN) return stored;
+  return HISTORY_LEN - HISTORY_BLOCK + head % HISTORY_BLOCK;
+}
+
+uint32_t historyCount(void)
+{
+  uint32_t n;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  n = readable();
+  xSemaphoreGive(lock);
+  return n;
+}
+
+/* caller holds the lock */
+static uint32_t readEntries(uint32_t first, historyPoint_t* out, uint32_t n)
+{
+  int16_t  temp[SAMPLE_PROBES];
+  uint32_t count = readable();
+  uint32_t slot, s;
+
+  if (first >= count) return 0;
+  if (n > count - first) n = count - first;
+
+  slot = (head + HISTORY_LEN - count + first) % HISTORY_LEN;
+  /* rebuild the first value from its keyframe, less than HISTORY_BLOCK steps */
+  s = slot - slot % HISTORY_BLOCK;
+  memcpy(temp, keys[s / HISTORY_BLOCK].temp, sizeof(temp));
+  while (s != slot)
+  {
+    s++;
+    for (uint8_t p = 0; p < SAMPLE_PROBES; p++) temp[p] += entries[s].delta[p];
+  }
+
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (i > 0)
+    {
+      slot = (slot + 1) % HISTORY_LEN;
+      for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+      {
+        if (slot % HISTORY_BLOCK == 0) temp[p] = keys[slot / HISTORY_BLOCK].temp[p];
+        else temp[p] += entries[slot].delta[p];
+      }
+    }
+    for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+    {
+      out[i].temp[p] = temp[p] / 100.0;
+    }
+    out[i].flags = entries[slot].flags;
+  }
+  return n;
+}
+
+uint32_t historyRead(uint32_t first, historyPoint_t* out, uint32_t n)
+{
+  xSemaphoreTake(lock, portMAX_DELAY);
+  n = readEntries(first, out, n);
+  xSemaphoreGive(lock);
+  return n;
+}
+
+bool historyPointAgo(uint32_t back, historyPoint_t* point)
+{
+  uint32_t n = 0;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (back < readable()) n = readEntries(readable() - 1 - back, point, 1);
+  xSemaphoreGive(lock);
+  return n == 1;
+}
@@ -0,0 +1,188 @@
+#include "tempStats.h"
+
+/* Samples are summed into buckets. A finished bucket enters its window
+ * in O(1): it is added to running sums (count, sum and the least squares
+ * terms, with the bucket number as time) and pushed on two monotonic
+ * deques that keep the window minimum and maximum at their front. The
+ * bucket leaving the window is subtracted from the sums and dropped from
+ * the deque fronts. Queries combine that with the bucket being filled.
+ */
+typedef struct {
+  uint32_t n;
+  float    sum;
+  float    min;
+  float    max;
+} bucket_t;
+
+/* deque of bucket numbers, oldest at head */
+typedef struct {
+  uint32_t item[STATS_BUCKETS];
+  uint8_t  head;
+  uint8_t  count;
+} deque_t;
+
+typedef struct {
+  bucket_t ring[STATS_BUCKETS];  /* finished buckets, by number % STATS_BUCKETS */
+  bucket_t cur;
+  uint32_t index;                /* number of the bucket being filled */
+  bool     started;
+  deque_t  minQ;
+  deque_t  maxQ;
+  /* running sums over the finished buckets, t = number - tBase */
+  double   n, sy, st, stt, sty;
+  uint32_t tBase;
+} window_t;
+
+static const uint32_t bucketMs[STATS_WINDOWS] = { 1000, 60000, 24 * 60000 };
+
+static window_t          windows[SAMPLE_PROBES][STATS_WINDOWS];
+static SemaphoreHandle_t lock = NULL;
+
+static uint32_t dequeAt(const deque_t* q, uint8_t i)
+{
+  return q->item[(q->head + i) % STATS_BUCKETS];
+}
+
+static void dequePopFront(deque_t* q)
+{
+  q->head = (q->head + 1) % STATS_BUCKETS;
+  q->count--;
+}
+
+/* keep the deque monotonic: drop the entries 'worse' pushes out */
+static void dequePush(deque_t* q, const bucket_t* ring, uint32_t k, bool isMin)
+{
+  float v = isMin ? ring[k % STATS_BUCKETS].min : ring[k % STATS_BUCKETS].max;
+
+  while (q->count > 0)
+  {
+    const bucket_t* back = &ring[dequeAt(q, q->count - 1) % STATS_BUCKETS];
+    if (isMin ? back->min < v : back->max > v) break;
+    q->count--;
+  }
+  q->item[(q->head + q->count) % STATS_BUCKETS] = k;
+  q->count++;
+}
+
+static void addSums(window_t* w, const bucket_t* b, uint32_t k, double sign)
+{
+  double t = (double)(k - w->tBase);
+
+  w->n   += sign * b->n;
+  w->sy  += sign * b->sum;
+  w->st  += sign * t * b->n;
+  w->stt += sign * t * t * b->n;
+  w->sty += sign * t * b->sum;
+}
+
+static void resetWindow(window_t* w, uint32_t index)
+{
+  memset(w, 0, sizeof(*w));
+  w->index   = index;
+  w->tBase   = index;
+  w->started = true;
+}
+
+/* close bucket w->index and open the next one */
+static void closeBucket(window_t* w)
+{
+  uint32_t  k    = w->index;
+  bucket_t* slot = &w->ring[k % STATS_BUCKETS];
+  double    c;
+
+  /* bucket k - STATS_BUCKETS leaves the window */
+  if (slot->n > 0) addSums(w, slot, k - STATS_BUCKETS, -1);
+  while (w->minQ.count > 0 && k - dequeAt(&w->minQ, 0) >= STATS_BUCKETS) dequePopFront(&w->minQ);
+  while (w->maxQ.count > 0 && k - dequeAt(&w->maxQ, 0) >= STATS_BUCKETS) dequePopFront(&w->maxQ);
+
+  *slot = w->cur;
+  if (slot->n > 0)
+  {
+    addSums(w, slot, k, 1);
+    dequePush(&w->minQ, w->ring, k, true);
+    dequePush(&w->maxQ, w->ring, k, false);
+  }
+
+  /* keep t small so the squares stay exact, shifting the sums */
+  if (k - w->tBase > 1000000)
+  {
+    c = k - w->tBase;
+    w->sty -= c * w->sy;
+    w->stt -= 2 * c * w->st - c * c * w->n;
+    w->st  -= c * w->n;
+    w->tBase = k;
+  }
+
+  memset(&w->cur, 0, sizeof(w->cur));
+  w->index = k + 1;
+}
+
+void statsBegin(void)
+{
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+}
+
+void statsAdd(const tempSample_t* sample)
+{
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+  {
+    /* a probe that didn't answer leaves the others alone */
+    if (!(sample->valid & SAMPLE_VALID(p))) continue;
+    for (uint8_t i = 0; i < STATS_WINDOWS; i++)
+    {
+      window_t* w     = &windows[p][i];
+      uint32_t  index = sample->stamp / bucketMs[i];
+      float     v     = sample->temp[p];
+
+      /* first sample, clock wrap, or a gap longer than the window */
+      if (!w->started || index < w->index || index - w->index > STATS_BUCKETS)
+      {
+        resetWindow(w, index);
+      }
+      while (w->index < index) closeBucket(w);
+
+      if (w->cur.n == 0 || v < w->cur.min) w->cur.min = v;
+      if (w->cur.n == 0 || v > w->cur.max) w->cur.max = v;
+      w->cur.sum += v;
+      w->cur.n++;
+    }
+  }
+  xSemaphoreGive(lock);
+}
+
+bool statsGet(uint8_t window, uint8_t probe, tempStats_t* stats)
+{
+  const window_t* w;
+  double n, sy, st, stt, sty, t, den;
+  float  min, max;
+
+  if (window >= STATS_WINDOWS || probe >= SAMPLE_PROBES) return false;
+  w = &windows[probe][window];
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  /* the current bucket on top of the finished ones */
+  t   = (double)(w->index - w->tBase);
+  n   = w->n   + w->cur.n;
+  sy  = w->sy  + w->cur.sum;
+  st  = w->st  + t * w->cur.n;
+  stt = w->stt + t * t * w->cur.n;
+  sty = w->sty + t * w->cur.sum;
+  min = w->cur.n ? w->cur.min :  INFINITY;
+  max = w->cur.n ? w->cur.max : -INFINITY;
+  if (w->minQ.count > 0) min = fminf(min, w->ring[dequeAt(&w->minQ, 0) % STATS_BUCKETS].min);
+  if (w->maxQ.count > 0) max = fmaxf(max, w->ring[dequeAt(&w->maxQ, 0) % STATS_BUCKETS].max);
+  xSemaphoreGive(lock);
+
+  memset(stats, 0, sizeof(*stats));
+  if (n < 0.5) return false;
+
+  stats->count = lround(n);
+  stats->min   = min;
+  stats->max   = max;
+  stats->mean  = sy / n;
+  /* slope per bucket, 0 until samples span two buckets */
+  den = n * stt - st * st;
+  if (den > 1e-9 * n * n) stats->slope = (n * sty - st * sy) / den * 3600000.0 / bucketMs[window];
+  return true;
+}
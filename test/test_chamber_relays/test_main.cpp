@@ -0,0 +1,94 @@
+/* Relay writes of chamberDriveRelays(), in the order they reach the pins:
+ * cooling and heating never on together, even for an instant, when the
+ * mode flips between them in one control step.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "chamber.h"
+
+#define WRITES (8)
+
+typedef struct {
+  uint8_t pin, level;
+} pinWrite_t;
+
+static pinWrite_t writes[WRITES];
+static uint8_t    count;
+static chamber_t* c = &chambers[0];
+
+static void onPinWrite(uint8_t pin, uint8_t level, void* /* arg */)
+{
+  TEST_ASSERT_LESS_THAN(WRITES, count);
+  writes[count].pin   = pin;
+  writes[count].level = level;
+  count++;
+  TEST_ASSERT_FALSE(hostPinLevel(c->coolPin) == HIGH && hostPinLevel(c->heatPin) == HIGH);
+}
+
+static void drive(bool fan, bool cool, bool heat)
+{
+  count = 0;
+  c->state.blowing = fan;
+  c->state.cooling = cool;
+  c->state.heating = heat;
+  chamberDriveRelays(c);
+}
+
+static void assertWrite(uint8_t i, uint8_t pin, uint8_t level)
+{
+  TEST_ASSERT_LESS_THAN(count, i);
+  TEST_ASSERT_EQUAL_UINT8(pin, writes[i].pin);
+  TEST_ASSERT_EQUAL_UINT8(level, writes[i].level);
+}
+
+void setUp(void)
+{
+  drive(false, false, false);
+}
+
+void tearDown(void)
+{
+}
+
+void test_cooling_to_heating(void)
+{
+  drive(true, true, false);
+  drive(true, false, true);
+  TEST_ASSERT_EQUAL_UINT8(2, count);
+  assertWrite(0, c->coolPin, LOW);
+  assertWrite(1, c->heatPin, HIGH);
+}
+
+void test_heating_to_cooling(void)
+{
+  drive(false, false, true);
+  drive(true, true, false);
+  TEST_ASSERT_EQUAL_UINT8(3, count);
+  assertWrite(0, c->heatPin, LOW);
+  assertWrite(1, c->fanPin, HIGH);
+  assertWrite(2, c->coolPin, HIGH);
+}
+
+/* a relay that keeps its state is not written again */
+void test_unchanged_relays(void)
+{
+  drive(true, true, false);
+  drive(true, true, false);
+  TEST_ASSERT_EQUAL_UINT8(0, count);
+}
+
+int main(void)
+{
+  hostBegin();
+  hostPreferencesClear();
+  chamberBegin(c, 0);
+  hostOnPinWrite(onPinWrite, NULL);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_cooling_to_heating);
+  RUN_TEST(test_heating_to_cooling);
+  RUN_TEST(test_unchanged_relays);
+  hostExit(UNITY_END());
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* Bus traffic of DallasTemperature with its device cache, counted in
+ * time slots on OneWireSim, and the bus-wide resolution it works out
+ * when probes come and go after begin().
+ */
+#include <Arduino.h>
+#include <OneWireSim.h>
+#include <DallasTemperature.h>
+#include <unity.h>
+#include "hostShim.h"
+
+/* slots of the library before the cache, three DS18B20 on the bus */
+#define UNCACHED_REQUEST (232)
+#define UNCACHED_SET_RES (1160)
+
+static OneWireSim        bus;
+static OneWire           wire(&bus);
+static DallasTemperature sensors(&wire);
+static int               spare;
+
+static uint32_t slotsOf(void (*fn)(void))
+{
+  uint32_t before = bus.slots;
+
+  fn();
+  return bus.slots - before;
+}
+
+static void requestFirst(void)
+{
+  sensors.requestTemperaturesByAddress(bus.rom(0));
+}
+
+static void setFirstTo9(void)
+{
+  sensors.setResolution(bus.rom(0), 9);
+}
+
+static void keepFirstAt9(void)
+{
+  sensors.setResolution(bus.rom(0), 9, true);
+}
+
+void setUp(void)
+{
+  /* three probes at 9 bits, the spare unplugged */
+  bus.setConnected(spare, false);
+  for (uint8_t i = 0; i < 3; i++) bus.setConnected(i, true);
+  sensors.begin();
+  sensors.setResolution(9);
+}
+
+void tearDown(void)
+{
+}
+
+/* a known device is asked to convert without reading its scratchpad */
+void test_request_by_address(void)
+{
+  uint32_t slots = slotsOf(requestFirst);
+
+  TEST_ASSERT_LESS_OR_EQUAL(80, slots);
+  TEST_ASSERT_LESS_THAN(UNCACHED_REQUEST, slots);
+}
+
+/* setResolution() reads again only what it doesn't know */
+void test_set_resolution(void)
+{
+  uint32_t cached, uncached;
+
+  cached = slotsOf(setFirstTo9);
+  sensors.invalidateCache();
+  uncached = slotsOf(setFirstTo9);
+  TEST_ASSERT_LESS_THAN(uncached, cached);
+  TEST_ASSERT_LESS_THAN(UNCACHED_SET_RES, cached);
+  TEST_ASSERT_EQUAL_UINT8(9, sensors.getResolution());
+
+  /* a device already at the resolution costs nothing */
+  TEST_ASSERT_EQUAL_UINT32(0, slotsOf(keepFirstAt9));
+}
+
+/* a probe plugged after begin() at its power-on 12 bits counts for the
+ * bus-wide resolution, though the cache covers as many devices as begin()
+ * found */
+void test_hot_plugged_probe(void)
+{
+  bus.setConnected(spare, true);
+  sensors.setResolution(bus.rom(0), 9);
+  TEST_ASSERT_EQUAL_UINT8(12, sensors.getResolution());
+  TEST_ASSERT_EQUAL_UINT32(750, sensors.millisToWaitForConversion(sensors.getResolution()));
+}
+
+/* an unplugged probe stops counting, though it is still cached */
+void test_unplugged_probe(void)
+{
+  sensors.setResolution(bus.rom(2), 12);
+  TEST_ASSERT_EQUAL_UINT8(12, sensors.getResolution());
+  bus.setConnected(2, false);
+  sensors.setResolution(bus.rom(0), 9);
+  TEST_ASSERT_EQUAL_UINT8(9, sensors.getResolution());
+}
+
+/* a device that stopped answering is forgotten */
+void test_failed_read_invalidates(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(9, sensors.getResolution(bus.rom(1)));
+  bus.setConnected(1, false);
+  TEST_ASSERT_EQUAL_FLOAT(DEVICE_DISCONNECTED_C, sensors.getTempC(bus.rom(1)));
+  TEST_ASSERT_EQUAL_UINT8(0, sensors.getResolution(bus.rom(1)));
+  bus.setConnected(1, true);
+  TEST_ASSERT_EQUAL_UINT8(9, sensors.getResolution(bus.rom(1)));
+}
+
+int main(void)
+{
+  hostBegin();
+  for (uint8_t i = 0; i < 3; i++) bus.addDevice(0x28, i + 1);
+  spare = bus.addDevice(0x28, 0x99);
+  sensors.setWaitForConversion(false);
+  sensors.setAutoSaveScratchPad(false);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_request_by_address);
+  RUN_TEST(test_set_resolution);
+  RUN_TEST(test_hot_plugged_probe);
+  RUN_TEST(test_unplugged_probe);
+  RUN_TEST(test_failed_read_invalidates);
+  hostExit(UNITY_END());
+  return 0;
+}
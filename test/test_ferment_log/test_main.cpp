@@ -0,0 +1,176 @@
+/* The flash log against the RAM history it copies: LittleFS is the
+ * in-memory file system of lib/HostShim, time runs on its virtual clock.
+ * Every history entry must reach the log once, under consecutive minutes,
+ * however the recording calls are spaced.
+ */
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "fermentLog.h"
+
+#define EPOCH      (1700000000)
+#define MAX_LOGGED (600)
+
+typedef struct {
+  uint32_t       minute[MAX_LOGGED];
+  historyPoint_t point[MAX_LOGGED];
+  uint32_t       n;
+} replayed_t;
+
+static replayed_t     logged;
+static historyPoint_t kept[MAX_LOGGED];
+static uint32_t       sunk = 0;
+static uint32_t       seed = 1;
+
+static void countingSink(const historyPoint_t* point, unsigned long stamp, void* arg)
+{
+  sunk++;
+  fermentLogSink(point, stamp, arg);
+}
+
+static void collect(uint32_t minute, const historyPoint_t* point, void* arg)
+{
+  replayed_t* r = (replayed_t*)arg;
+
+  if (r->n == MAX_LOGGED) return;
+  r->minute[r->n] = minute;
+  r->point[r->n]  = *point;
+  r->n++;
+}
+
+static uint32_t nextRandom(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+/* Record a slowly moving sample for 'seconds', called at irregular
+ * intervals as vTempControl is, every 500 ms to 3 s */
+static void record(uint32_t seconds)
+{
+  unsigned long end = millis() + seconds * 1000UL;
+  tempSample_t  sample;
+
+  while (millis() < end)
+  {
+    sample.temp[PROBE_CHAMBER] = 18 + 4 * sinf(millis() / 3.6e6);
+    sample.temp[PROBE_LIQUID]  = 20 + cosf(millis() / 7.2e6);
+    sample.valid = nextRandom() % 50 != 0 ? SAMPLE_ALL : 0;
+    sample.stamp = millis();
+    historyRecord(&sample, sample.valid ? HIST_FAN : 0, millis());
+    hostRun(500 + nextRandom() % 2500);
+  }
+}
+
+/* Compare the log with the last 'n' history entries */
+static void checkLog(uint32_t n)
+{
+  uint32_t count = historyCount();
+
+  fermentLogFlush();
+  logged.n = 0;
+  fermentLogReplay(0, collect, &logged);
+  TEST_ASSERT_EQUAL_UINT32(n, logged.n);
+  TEST_ASSERT_EQUAL_UINT32(n, historyRead(count - n, kept, n));
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (i > 0) TEST_ASSERT_EQUAL_UINT32(logged.minute[i - 1] + 1, logged.minute[i]);
+    TEST_ASSERT_EQUAL_UINT8(kept[i].flags, logged.point[i].flags);
+    for (uint8_t p = 0; p < SAMPLE_PROBES; p++)
+    {
+      TEST_ASSERT_FLOAT_WITHIN(0.006, kept[i].temp[p], logged.point[i].temp[p]);
+    }
+  }
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/* nothing is logged before NTP answered, then every entry once */
+void test_every_entry_once(void)
+{
+  record(5 * 60);
+  TEST_ASSERT_EQUAL_UINT32(0, fermentLogLastMinute());
+  configTime(0, 0, "pool.ntp.org");
+  record(HOST_NTP_DELAY / 1000 + 1);
+  sunk = 0;
+
+  record(3 * 3600);
+  TEST_ASSERT_UINT32_WITHIN(1, 3 * 60, sunk);
+  checkLog(sunk);
+  TEST_ASSERT_EQUAL_UINT32(logged.minute[logged.n - 1], fermentLogLastMinute());
+  TEST_ASSERT_LESS_OR_EQUAL(FLOG_DRIFT, labs((long)(time(nullptr) / 60) - (long)fermentLogLastMinute()));
+}
+
+/* minutes recorded late, the task held up, come in as invalid entries
+ * that keep the minutes consecutive */
+void test_missed_periods(void)
+{
+  uint32_t before = sunk;
+
+  hostRun(7 * 60000);
+  record(3600);
+  TEST_ASSERT_UINT32_WITHIN(1, before + 7 + 60, sunk);
+  checkLog(sunk);
+}
+
+/* the clock moved back: the minutes keep going forward, none repeats */
+void test_clock_back(void)
+{
+  uint32_t before = sunk;
+
+  hostSetEpoch(EPOCH - 10 * 60);
+  record(3600);
+  TEST_ASSERT_UINT32_WITHIN(1, before + 60, sunk);
+  checkLog(sunk);
+}
+
+/* the clock jumped ahead: the log follows it with a new record */
+void test_clock_ahead(void)
+{
+  uint32_t last, before;
+
+  hostSetEpoch(EPOCH + 60 * 60);
+  before = fermentLogLastMinute();
+  record(30 * 60);
+  last = fermentLogLastMinute();
+  TEST_ASSERT_GREATER_THAN(before + 30 + 50, last);
+  TEST_ASSERT_LESS_OR_EQUAL(FLOG_DRIFT, labs((long)(time(nullptr) / 60) - (long)last));
+}
+
+/* a reset: the log is opened again and found to end where it did */
+void test_reopen(void)
+{
+  uint32_t last;
+
+  fermentLogFlush();
+  last = fermentLogLastMinute();
+  TEST_ASSERT_TRUE(fermentLogBegin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(last, fermentLogLastMinute());
+}
+
+int main(void)
+{
+  hostBegin();
+  hostFilesClear();
+  hostSetEpoch(EPOCH);
+  historyBegin();
+  LittleFS.begin(true);
+  fermentLogBegin(LittleFS);
+  historySetSink(countingSink, NULL);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_every_entry_once);
+  RUN_TEST(test_missed_periods);
+  RUN_TEST(test_clock_back);
+  RUN_TEST(test_clock_ahead);
+  RUN_TEST(test_reopen);
+  hostExit(UNITY_END());
+  return 0;
+}
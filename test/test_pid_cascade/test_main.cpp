@@ -0,0 +1,64 @@
+/* The cascade inside PID_OUTER_BAND: the duty is held at 0 and the inner
+ * integral with it, so the first window after the liquid leaves the band
+ * is sized by the error of that moment and not by the wait.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "pidControl.h"
+
+#define SP (20.0f)
+#define DT (10.0f)  /* s between samples */
+
+static cascade_t c;
+
+void setUp(void)
+{
+  cascadeInit(&c);
+}
+
+void tearDown(void)
+{
+}
+
+/* the liquid a little cold, the air a little colder: heating is due but
+ * the band holds it back for an hour */
+void test_band_holds_inner_integral(void)
+{
+  for (int i = 0; i < 360; i++)
+  {
+    TEST_ASSERT_EQUAL_FLOAT(0, cascadeUpdate(&c, SP, SP - PID_OUTER_BAND / 2, SP - 0.5f, DT));
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0, c.inner.integral);
+}
+
+/* leaving the band the inner integral starts from where it was held */
+void test_leaving_band_starts_fresh(void)
+{
+  float duty;
+
+  for (int i = 0; i < 360; i++) cascadeUpdate(&c, SP, SP - PID_OUTER_BAND / 2, SP - 0.5f, DT);
+  duty = cascadeUpdate(&c, SP, SP - 2 * PID_OUTER_BAND, SP + 1.5f, DT);
+  TEST_ASSERT_GREATER_THAN_FLOAT(0, duty);
+  TEST_ASSERT_LESS_THAN_FLOAT(1, duty);
+  TEST_ASSERT_EQUAL_FLOAT(PID_INNER_KI * (c.chamberSp - (SP + 1.5f)) * DT, c.inner.integral);
+}
+
+/* outside the band the inner loop integrates as usual */
+void test_inner_integrates_outside_band(void)
+{
+  cascadeUpdate(&c, SP, SP - 2 * PID_OUTER_BAND, SP + 1.5f, DT);
+  TEST_ASSERT_GREATER_THAN_FLOAT(0, c.inner.integral);
+}
+
+int main(void)
+{
+  hostBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_band_holds_inner_integral);
+  RUN_TEST(test_leaving_band_starts_fresh);
+  RUN_TEST(test_inner_integrates_outside_band);
+  hostExit(UNITY_END());
+  return 0;
+}
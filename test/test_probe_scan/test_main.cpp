@@ -0,0 +1,132 @@
+/* The background probe scan sharing the bus with the reader, on
+ * simulated DS18B20 powered from the data line: the scan must leave a
+ * conversion alone, and a probe that left the bus can't be given a role.
+ */
+#include <Arduino.h>
+#include <OneWireSim.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "chamber.h"
+#include "probeScan.h"
+#include "sensorReadings.h"
+
+#define PROBES (2 * SAMPLE_PROBES)  /* the two chambers of the host tokens.h */
+
+extern OneWire oneWire;
+
+static OneWireSim bus;
+static int        probe[PROBES];
+static uint32_t   samples = 0;
+
+static uint32_t busClock(void)
+{
+  return (uint32_t)hostMicros();
+}
+
+/* vReadTempTask without the sample exchange */
+static void vReader(void* px)
+{
+  static uint8_t*      addrs[PROBES];
+  static DeviceAddress roms[PROBES];
+  static int16_t       raws[PROBES];
+  dsReader_t    reader;
+  unsigned long waitMs;
+
+  for (uint8_t i = 0; i < PROBES; i++) addrs[i] = chambers[i / SAMPLE_PROBES].probe[i % SAMPLE_PROBES];
+  dsReaderInit(&reader, addrs, roms, raws, PROBES, 500, 2500);
+  while (1)
+  {
+    if (dsReaderStep(&reader, millis(), &waitMs)) samples++;
+    vTaskDelay(pdMS_TO_TICKS(waitMs));
+  }
+}
+
+static int8_t slotOf(int index)
+{
+  probeSlot_t list[PROBE_SLOTS];
+
+  probeScanList(list);
+  for (uint8_t i = 0; i < PROBE_SLOTS; i++)
+  {
+    if (list[i].used && memcmp(list[i].rom, bus.rom(index), 8) == 0) return i;
+  }
+  return -1;
+}
+
+static bool slotGone(int8_t slot)
+{
+  probeSlot_t list[PROBE_SLOTS];
+
+  probeScanList(list);
+  return list[slot].missed >= PROBE_MISS_LIMIT;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/* every pass of the scan runs while the reader keeps converting, none of
+ * the conversions may lose its strong pull-up */
+void test_scan_spares_parasite_conversions(void)
+{
+  uint32_t conversions = bus.conversions;
+
+  hostRun(10 * 60000);
+  TEST_ASSERT_GREATER_THAN(100, bus.conversions - conversions);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.failedConversions);
+  TEST_ASSERT_GREATER_THAN(100, samples);
+  for (uint8_t i = 0; i < PROBES; i++)
+  {
+    TEST_ASSERT_TRUE(slotOf(probe[i]) >= 0);
+    TEST_ASSERT_FALSE(slotGone(slotOf(probe[i])));
+  }
+}
+
+/* a gone probe keeps its slot so /probes shows it, but takes no role */
+void test_gone_probe_refused(void)
+{
+  int8_t slot = slotOf(probe[PROBE_LIQUID]);
+
+  bus.setConnected(probe[PROBE_LIQUID], false);
+  hostRun((PROBE_MISS_LIMIT + 1) * PROBE_SCAN_PERIOD);
+  TEST_ASSERT_TRUE(slotGone(slot));
+  TEST_ASSERT_FALSE(probeAssign(slot, SAMPLE_PROBES + PROBE_LIQUID));
+  TEST_ASSERT_EQUAL_UINT32(0, bus.failedConversions);
+
+  bus.setConnected(probe[PROBE_LIQUID], true);
+  hostRun(2 * PROBE_SCAN_PERIOD);
+  TEST_ASSERT_FALSE(slotGone(slot));
+  TEST_ASSERT_TRUE(probeAssign(slot, PROBE_LIQUID));
+}
+
+int main(void)
+{
+  uint64_t serial;
+
+  hostBegin();
+  hostPreferencesClear();
+  bus.setClock(busClock);
+  for (uint8_t i = 0; i < PROBES; i++)
+  {
+    const uint8_t* addr = chambers[i / SAMPLE_PROBES].probe[i % SAMPLE_PROBES];
+
+    serial = 0;
+    for (int b = 6; b >= 1; b--) serial = serial << 8 | addr[b];
+    probe[i] = bus.addDevice(addr[0], serial, true);
+  }
+  oneWire.begin(&bus);
+  setupSensorsOnOneWire();
+  probeScanBegin();
+  xTaskCreate(vReader,        "readTemp",  0x2000, NULL, 2, NULL);
+  xTaskCreate(vProbeScanTask, "probeScan", 0x2000, NULL, 1, NULL);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_scan_spares_parasite_conversions);
+  RUN_TEST(test_gone_probe_refused);
+  hostExit(UNITY_END());
+  return 0;
+}
@@ -0,0 +1,127 @@
+/* A probe that stops answering takes out only what depends on it: the
+ * hysteresis modes go on from the chamber probe, MODE_PID needs both,
+ * and the statistics keep the probe that still reads.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "tempControl.h"
+#include "tempStats.h"
+
+#define START (COOL_WAIT + 1)
+
+static ctrlState_t    st;
+static ctrlSettings_t set;
+static tempSample_t   sample;
+
+/* a control step at 'now' on a fresh sample with the probes of 'valid' */
+static void step(uint32_t valid, float chamber, uint32_t now)
+{
+  sample.temp[PROBE_CHAMBER] = chamber;
+  sample.temp[PROBE_LIQUID]  = valid & SAMPLE_VALID(PROBE_LIQUID) ? chamber : -127;
+  sample.valid = valid;
+  sample.stamp = now;
+  controlStep(&st, &set, &sample, now);
+}
+
+void setUp(void)
+{
+  controlInit(&st, 0);
+  set.tempH  = 20;
+  set.tempL  = 18;
+  set.tempHH = 22;
+  set.tempLL = 16;
+}
+
+void tearDown(void)
+{
+}
+
+void test_cool_without_liquid_probe(void)
+{
+  set.selectedMode = MODE_COOL;
+  step(SAMPLE_VALID(PROBE_CHAMBER), 21, START);
+  TEST_ASSERT_TRUE(st.cooling);
+}
+
+void test_heat_without_liquid_probe(void)
+{
+  set.selectedMode = MODE_HEAT;
+  step(SAMPLE_VALID(PROBE_CHAMBER), 17, START);
+  TEST_ASSERT_TRUE(st.heating);
+}
+
+void test_auto_without_liquid_probe(void)
+{
+  set.selectedMode = MODE_AUTO;
+  step(SAMPLE_VALID(PROBE_CHAMBER), 23, START);
+  TEST_ASSERT_TRUE(st.cooling);
+}
+
+/* without the chamber probe nothing runs */
+void test_no_chamber_probe(void)
+{
+  set.selectedMode = MODE_COOL;
+  step(SAMPLE_ALL, 21, START);
+  TEST_ASSERT_TRUE(st.cooling);
+  step(SAMPLE_VALID(PROBE_LIQUID), 21, START + 1000);
+  TEST_ASSERT_FALSE(st.cooling);
+  TEST_ASSERT_FALSE(st.heating);
+}
+
+/* the cascade follows the liquid: without it the relays stop */
+void test_pid_without_liquid_probe(void)
+{
+  uint32_t t;
+
+  set.selectedMode = MODE_PID;
+  /* the first window opens before the cascade has a duty */
+  for (t = START; t < START + 2 * PID_PERIOD && !st.heating; t += 1000) step(SAMPLE_ALL, 10, t);
+  TEST_ASSERT_TRUE(st.heating);
+  step(SAMPLE_VALID(PROBE_CHAMBER), 10, t + 1000);
+  TEST_ASSERT_FALSE(st.heating);
+  TEST_ASSERT_FALSE(st.pidActive);
+}
+
+/* a stale sample counts as no probe at all */
+void test_stale_sample(void)
+{
+  set.selectedMode = MODE_COOL;
+  step(SAMPLE_ALL, 21, START);
+  TEST_ASSERT_TRUE(st.cooling);
+  controlStep(&st, &set, &sample, START + SAMPLE_MAX_AGE + 1);
+  TEST_ASSERT_FALSE(st.cooling);
+  TEST_ASSERT_EQUAL_UINT32(0, sample.valid);
+}
+
+void test_stats_keep_answering_probe(void)
+{
+  tempStats_t stats;
+
+  sample.temp[PROBE_CHAMBER] = 19;
+  sample.temp[PROBE_LIQUID]  = -127;
+  sample.valid = SAMPLE_VALID(PROBE_CHAMBER);
+  sample.stamp = 1000;
+  statsAdd(&sample);
+  TEST_ASSERT_TRUE(statsGet(0, PROBE_CHAMBER, &stats));
+  TEST_ASSERT_EQUAL_UINT32(1, stats.count);
+  TEST_ASSERT_EQUAL_FLOAT(19, stats.mean);
+  TEST_ASSERT_FALSE(statsGet(0, PROBE_LIQUID, &stats));
+}
+
+int main(void)
+{
+  hostBegin();
+  statsBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_cool_without_liquid_probe);
+  RUN_TEST(test_heat_without_liquid_probe);
+  RUN_TEST(test_auto_without_liquid_probe);
+  RUN_TEST(test_no_chamber_probe);
+  RUN_TEST(test_pid_without_liquid_probe);
+  RUN_TEST(test_stale_sample);
+  RUN_TEST(test_stats_keep_answering_probe);
+  hostExit(UNITY_END());
+  return 0;
+}
@@ -0,0 +1,186 @@
+/* The RMT transport's encoder and decoder against a simulated echo: the
+ * link records what a DS18B20 on the bus would have made of each slot,
+ * with the receiver's quirks the decoder has to live with.
+ */
+#include <Arduino.h>
+#include <OneWireRmt.h>
+#include <unity.h>
+#include "hostShim.h"
+
+#define ECHO_LEVELS (2 * ONEWIRE_RMT_ECHO)
+
+/* Echo of the items sent: a presence pulse after a reset, and from slot
+ * 'readFrom' on, counted over the transfers, a device holding the bus
+ * low for 40 us where it answers a 0. */
+class EchoLink : public OneWireRmtLink
+{
+  public:
+    bool     present;
+    bool     fail;
+    uint32_t leadHigh;   /* idle bus recorded before the first slot */
+    uint32_t shrink;     /* us the receiver misses per slot */
+    uint32_t readFrom;
+    uint32_t slots;
+    uint32_t transfers;
+    uint8_t  answer[16];
+
+    void reset(void)
+    {
+      present = true;
+      fail = false;
+      leadHigh = shrink = 0;
+      readFrom = slots = transfers = 0;
+      memset(answer, 0xFF, sizeof(answer));
+    }
+
+    bool transfer(const OneWireRmtItem *items, uint8_t count, bool rst,
+                  OneWireRmtItem *echo, size_t *n)
+    {
+      transfers++;
+      if (fail) return false;
+      levels = 0;
+      if (leadHigh) level(1, leadHigh);
+      for (uint8_t i = 0; i < count; i++) {
+        uint32_t low = items[i].duration0, high = items[i].duration1 - shrink;
+
+        if (rst && i == 0) {
+          level(0, low);
+          if (present) {
+            level(1, 30);
+            level(0, 120);
+            level(1, high - 150);
+          }
+          else level(1, high);
+          continue;
+        }
+        if (slots >= readFrom && slots - readFrom < 8 * sizeof(answer) &&
+            !(answer[(slots - readFrom) >> 3] >> ((slots - readFrom) & 7) & 1)) {
+          high += low - 40;
+          low = 40;
+        }
+        slots++;
+        level(0, low);
+        level(1, high);
+      }
+      /* the receiver stops on the idle bus after the last slot */
+      duration[levels - 1] = 0;
+      for (size_t i = 0; i < levels; i += 2) {
+        echo[i / 2].level0 = level0[i];
+        echo[i / 2].duration0 = duration[i];
+        echo[i / 2].level1 = i + 1 < levels ? level0[i + 1] : 1;
+        echo[i / 2].duration1 = i + 1 < levels ? duration[i + 1] : 0;
+      }
+      *n = (levels + 1) / 2;
+      return true;
+    }
+
+  private:
+    uint8_t  level0[ECHO_LEVELS];
+    uint32_t duration[ECHO_LEVELS];
+    size_t   levels;
+
+    void level(uint8_t l, uint32_t d)
+    {
+      TEST_ASSERT_LESS_THAN(ECHO_LEVELS, levels);
+      level0[levels] = l;
+      duration[levels++] = d;
+    }
+};
+
+static EchoLink   bus;
+static OneWireRmt rmt(&bus);
+
+/* MATCH ROM, READ SCRATCHPAD and the scratchpad of a probe at 85.00 */
+static const uint8_t command[10] = { 0x55, 0x28, 1, 2, 3, 4, 5, 6, 7, 0xBE };
+static const uint8_t scratchpad[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x1C };
+
+static void readScratchpad(void)
+{
+  uint8_t got[9];
+
+  bus.readFrom = 8 * sizeof(command);
+  memcpy(bus.answer, scratchpad, sizeof(scratchpad));
+  TEST_ASSERT_TRUE(rmt.transaction(true, command, sizeof(command), got, sizeof(got)));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(scratchpad, got, sizeof(got));
+  /* 153 slots: two transfers */
+  TEST_ASSERT_EQUAL_UINT32(2, bus.transfers);
+}
+
+void setUp(void)
+{
+  bus.reset();
+  rmt.errors = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_scratchpad(void)
+{
+  readScratchpad();
+  TEST_ASSERT_EQUAL_UINT32(0, rmt.errors);
+}
+
+/* the receiver started ahead of the transmitter: the idle bus it caught
+ * first, longer than a reset, isn't taken for time on the bus */
+void test_leading_idle_bus(void)
+{
+  bus.leadHigh = 1000;
+  readScratchpad();
+  TEST_ASSERT_EQUAL_UINT8(1, rmt.reset());
+  TEST_ASSERT_EQUAL_UINT32(0, rmt.errors);
+}
+
+/* a receiver that records each slot a microsecond short doesn't lose
+ * track of the slots over a whole transfer */
+void test_short_slots(void)
+{
+  bus.shrink = 1;
+  readScratchpad();
+  TEST_ASSERT_EQUAL_UINT32(0, rmt.errors);
+}
+
+void test_presence(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(1, rmt.reset());
+  bus.present = false;
+  TEST_ASSERT_EQUAL_UINT8(0, rmt.reset());
+  TEST_ASSERT_FALSE(rmt.transaction(true, command, sizeof(command), NULL, 0));
+  /* no device is not a failed transfer */
+  TEST_ASSERT_EQUAL_UINT32(0, rmt.errors);
+}
+
+void test_bits(void)
+{
+  bus.answer[0] = 0xFE;
+  TEST_ASSERT_EQUAL_UINT8(0, rmt.read_bit());
+  TEST_ASSERT_EQUAL_UINT8(1, rmt.read_bit());
+  rmt.write_bit(0);
+  rmt.write_bit(1);
+  TEST_ASSERT_EQUAL_UINT32(4, bus.transfers);
+  TEST_ASSERT_EQUAL_UINT32(0, rmt.errors);
+}
+
+void test_failed_transfer(void)
+{
+  bus.fail = true;
+  TEST_ASSERT_EQUAL_UINT8(0, rmt.reset());
+  TEST_ASSERT_EQUAL_UINT8(1, rmt.read_bit());
+  TEST_ASSERT_EQUAL_UINT32(2, rmt.errors);
+}
+
+int main(void)
+{
+  hostBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_scratchpad);
+  RUN_TEST(test_leading_idle_bus);
+  RUN_TEST(test_short_slots);
+  RUN_TEST(test_presence);
+  RUN_TEST(test_bits);
+  RUN_TEST(test_failed_transfer);
+  hostExit(UNITY_END());
+  return 0;
+}
@@ -0,0 +1,193 @@
+/* The sensor stack on simulated DS18B20 powered from their own supply:
+ * the reader's conversion pipeline, DallasTemperature::readAll() and its
+ * cache, and a probe swapped on a running bus.
+ */
+#include <Arduino.h>
+#include <OneWireSim.h>
+#include <unity.h>
+#include "hostShim.h"
+#include "chamber.h"
+#include "probeScan.h"
+#include "sensorReadings.h"
+
+#define PROBES (2 * SAMPLE_PROBES)  /* the two chambers of the host tokens.h */
+#define FAST   (500)
+#define SLOW   (2500)
+
+extern OneWire           oneWire;
+extern DallasTemperature sensors;
+
+static OneWireSim    bus;
+static int           probe[PROBES];
+static int           spare;
+static uint8_t*      addrs[PROBES];
+static DeviceAddress roms[PROBES];
+static int16_t       raws[PROBES];
+static dsReader_t    reader;
+
+static uint32_t busClock(void)
+{
+  return (uint32_t)hostMicros();
+}
+
+static int16_t raw(float celsius)
+{
+  return (int16_t)(celsius * 128);
+}
+
+/* step the reader until it collects a sample */
+static void sample(void)
+{
+  unsigned long waitMs;
+
+  while (!dsReaderStep(&reader, millis(), &waitMs)) hostRun(waitMs);
+}
+
+void setUp(void)
+{
+  for (uint8_t i = 0; i < PROBES; i++) bus.setTemperature(probe[i], 18 + i);
+}
+
+void tearDown(void)
+{
+}
+
+/* one conversion for every probe, requested again as soon as collected,
+ * and no bus traffic while it runs */
+void test_reader_states(void)
+{
+  unsigned long waitMs, start;
+  uint32_t slots, conversions;
+
+  dsReaderInit(&reader, addrs, roms, raws, PROBES, FAST, SLOW);
+  TEST_ASSERT_EQUAL_INT(DS_READ_IDLE, reader.state);
+
+  start = millis();
+  conversions = bus.conversions;
+  TEST_ASSERT_FALSE(dsReaderStep(&reader, start, &waitMs));
+  TEST_ASSERT_EQUAL_INT(DS_READ_CONVERTING, reader.state);
+  TEST_ASSERT_EQUAL_UINT32(750, reader.convMs);  /* DS_RES_SLOW */
+  TEST_ASSERT_EQUAL_UINT32(SLOW, waitMs);
+  TEST_ASSERT_EQUAL_UINT32(PROBES, bus.conversions - conversions);
+
+  hostRun(100);
+  slots = bus.slots;
+  TEST_ASSERT_FALSE(dsReaderStep(&reader, millis(), &waitMs));
+  TEST_ASSERT_EQUAL_UINT32(650, waitMs);
+  TEST_ASSERT_EQUAL_UINT32(slots, bus.slots);
+
+  hostRun(waitMs);
+  TEST_ASSERT_TRUE(dsReaderStep(&reader, millis(), &waitMs));
+  for (uint8_t i = 0; i < PROBES; i++) TEST_ASSERT_EQUAL_INT16(raw(18 + i), raws[i]);
+  TEST_ASSERT_EQUAL_INT(DS_READ_CONVERTING, reader.state);
+  TEST_ASSERT_EQUAL_UINT32(millis(), reader.started);
+  TEST_ASSERT_EQUAL_UINT32(2 * PROBES, bus.conversions - conversions);
+}
+
+/* a relay switch brings the probes down to DS_RES_FAST and the reader to
+ * its fast rate */
+void test_reader_boost(void)
+{
+  unsigned long waitMs;
+
+  dsReaderBoost();
+  sample();
+  TEST_ASSERT_TRUE(reader.boosted);
+  TEST_ASSERT_EQUAL_UINT8(DS_RES_FAST, reader.resolution);
+  TEST_ASSERT_EQUAL_UINT32(94, reader.convMs);
+  for (uint8_t i = 0; i < PROBES; i++) TEST_ASSERT_EQUAL_UINT8(DS_RES_FAST, sensors.getResolution(roms[i]));
+
+  hostRun(DS_BOOST_MS);
+  sample();
+  TEST_ASSERT_FALSE(dsReaderStep(&reader, millis(), &waitMs));
+  TEST_ASSERT_FALSE(reader.boosted);
+  TEST_ASSERT_EQUAL_UINT32(750, reader.convMs);
+}
+
+/* a probe that doesn't answer, or answers with a bad CRC, is marked
+ * disconnected without holding back the others */
+void test_read_all(void)
+{
+  sensors.requestTemperatures();
+  hostRun(750);
+  bus.setConnected(probe[2], false);
+  bus.injectCrcFaults(probe[1], 1);
+  TEST_ASSERT_EQUAL_UINT8(PROBES - 2, sensors.readAll(roms, PROBES, raws));
+  TEST_ASSERT_EQUAL_INT16(raw(18), raws[0]);
+  TEST_ASSERT_EQUAL_INT16(DEVICE_DISCONNECTED_RAW, raws[1]);
+  TEST_ASSERT_EQUAL_INT16(DEVICE_DISCONNECTED_RAW, raws[2]);
+  TEST_ASSERT_EQUAL_INT16(raw(21), raws[3]);
+
+  bus.setConnected(probe[2], true);
+  TEST_ASSERT_EQUAL_UINT8(PROBES, sensors.readAll(roms, PROBES, raws));
+  TEST_ASSERT_EQUAL_INT16(raw(19), raws[1]);
+  TEST_ASSERT_EQUAL_INT16(raw(20), raws[2]);
+}
+
+/* a failed read drops the probe from the cache: its resolution is read
+ * from the bus again instead of trusted */
+void test_cache_invalidation(void)
+{
+  uint32_t slots;
+
+  sensors.readAll(roms, PROBES, raws);
+  slots = bus.slots;
+  TEST_ASSERT_EQUAL_UINT8(12, sensors.getResolution(roms[0]));
+  TEST_ASSERT_EQUAL_UINT32(slots, bus.slots);
+
+  bus.injectCrcFaults(probe[0], 1);
+  sensors.readAll(roms, PROBES, raws);
+  TEST_ASSERT_EQUAL_INT16(DEVICE_DISCONNECTED_RAW, raws[0]);
+  slots = bus.slots;
+  TEST_ASSERT_EQUAL_UINT8(12, sensors.getResolution(roms[0]));
+  TEST_ASSERT_GREATER_THAN(slots, bus.slots);
+}
+
+/* the liquid probe of the first chamber replaced on the running bus: the
+ * scan hands its role to the new probe and the reader follows it */
+void test_probe_swap(void)
+{
+  bus.setTemperature(spare, 30);
+  xTaskCreate(vProbeScanTask, "probeScan", 0x2000, NULL, 1, NULL);
+  hostRun(2 * PROBE_SCAN_PERIOD);
+
+  bus.setConnected(probe[PROBE_LIQUID], false);
+  bus.setConnected(spare, true);
+  hostRun((PROBE_MISS_LIMIT + 2) * PROBE_SCAN_PERIOD);
+  TEST_ASSERT_EQUAL_MEMORY(bus.rom(spare), chambers[0].probe[PROBE_LIQUID], 8);
+
+  sample();
+  sample();
+  TEST_ASSERT_EQUAL_INT16(raw(30), raws[PROBE_LIQUID]);
+  TEST_ASSERT_EQUAL_INT16(raw(18), raws[PROBE_CHAMBER]);
+}
+
+int main(void)
+{
+  uint64_t serial;
+
+  hostBegin();
+  hostPreferencesClear();
+  bus.setClock(busClock);
+  for (uint8_t i = 0; i < PROBES; i++)
+  {
+    addrs[i] = chambers[i / SAMPLE_PROBES].probe[i % SAMPLE_PROBES];
+    serial = 0;
+    for (int b = 6; b >= 1; b--) serial = serial << 8 | addrs[i][b];
+    probe[i] = bus.addDevice(addrs[i][0], serial);
+  }
+  spare = bus.addDevice(0x28, 0x55);
+  bus.setConnected(spare, false);
+  oneWire.begin(&bus);
+  setupSensorsOnOneWire();
+  probeScanBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_reader_states);
+  RUN_TEST(test_reader_boost);
+  RUN_TEST(test_read_all);
+  RUN_TEST(test_cache_invalidation);
+  RUN_TEST(test_probe_swap);
+  hostExit(UNITY_END());
+  return 0;
+}
@@ -0,0 +1,120 @@
+/* Cost of /status: heap allocations and bytes formatted per call, for a
+ * state that changed since the last /status and for one that didn't.
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <new>
+#include <unity.h>
+#include "hostShim.h"
+#include "chamber.h"
+#include "sampleExchange.h"
+
+#define CALLS (10000)
+
+const char *renderStatus(const chamber_t *c, const tempSample_t *sample);
+
+static bool     counting = false;
+static uint32_t allocations = 0;
+
+void *operator new(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+
+  if (p == NULL) throw std::bad_alloc();
+  if (counting) allocations++;
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t /* size */) noexcept
+{
+  free(p);
+}
+
+static tempSample_t sample;
+
+/* ns per call over CALLS calls, the liquid moving by 'step' each time */
+static double timeCalls(float step)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < CALLS; i++) {
+    sample.temp[PROBE_LIQUID] += step;
+    renderStatus(&chambers[0], &sample);
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS;
+}
+
+void setUp(void)
+{
+  sample.temp[PROBE_CHAMBER] = 18.25;
+  sample.temp[PROBE_LIQUID]  = 19.5;
+  sample.valid = SAMPLE_ALL;
+}
+
+void tearDown(void)
+{
+}
+
+void test_no_allocations(void)
+{
+  allocations = 0;
+  counting = true;
+  timeCalls(0.01);
+  timeCalls(0);
+  counting = false;
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+/* an unchanged state is not formatted again: a mark left in the text
+ * stays, and a new value replaces it */
+void test_cached_text(void)
+{
+  char *text = (char *)renderStatus(&chambers[0], &sample);
+
+  TEST_ASSERT_NOT_NULL(strstr(text, "19.50"));
+  text[0] = '#';
+  TEST_ASSERT_EQUAL_PTR(text, renderStatus(&chambers[0], &sample));
+  TEST_ASSERT_EQUAL_INT('#', text[0]);
+
+  sample.temp[PROBE_LIQUID] = 19.75;
+  TEST_ASSERT_EQUAL_PTR(text, renderStatus(&chambers[0], &sample));
+  TEST_ASSERT_NOT_EQUAL('#', text[0]);
+  TEST_ASSERT_NOT_NULL(strstr(text, "19.75"));
+
+  /* nor is another chamber taken for the one rendered */
+  if (numChambers > 1) {
+    renderStatus(&chambers[1], &sample);
+    TEST_ASSERT_NOT_NULL(strstr(text, "Cámara 2"));
+  }
+}
+
+void test_cost_per_call(void)
+{
+  size_t bytes = strlen(renderStatus(&chambers[0], &sample)) + 1;
+  double changed = timeCalls(0.01);
+  double cached  = timeCalls(0);
+  char   line[120];
+
+  snprintf(line, sizeof(line), "/status: %u bytes, %.0f ns formatted, %.0f ns cached",
+           (unsigned)bytes, changed, cached);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(768, bytes);  /* STATUS_SIZE: not cut */
+  TEST_ASSERT_LESS_THAN(changed, cached);
+}
+
+int main(void)
+{
+  hostBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_no_allocations);
+  RUN_TEST(test_cached_text);
+  RUN_TEST(test_cost_per_call);
+  hostExit(UNITY_END());
+  return 0;
+}
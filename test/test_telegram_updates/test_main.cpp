@@ -0,0 +1,180 @@
+/* Updates fetched by the bot from the Bot API stand-in of the host shim:
+ * heap allocations per update while they are parsed into the messages,
+ * and a message too long for its fields kept away from the commands.
+ */
+#include <Arduino.h>
+#include <WiFi.h>
+#include <new>
+#include <unity.h>
+#include "hostShim.h"
+#include "botSender.h"
+#include "tokens.h"
+
+#define CHAT    "123456789"
+#define BATCH   (HANDLE_MESSAGES)
+
+/* the host String sits on std::string, which keeps up to 15 characters
+ * inline: the texts and names here are longer so that a String field
+ * allocates as it does on the ESP32 */
+#define SENDER  "Bartholomew the brewer"
+
+extern UniversalTelegramBot bot;
+void handleNewMessages(int numNewMessages);
+
+static bool     counting = false;
+static uint32_t allocations = 0;
+static uint32_t replies = 0;
+static size_t   replyLength = 0;
+static char     replyLast = 0;
+
+void *operator new(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+
+  if (p == NULL) throw std::bad_alloc();
+  if (counting) allocations++;
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t /* size */) noexcept
+{
+  free(p);
+}
+
+static void onReply(const char * /* chat_id */, const char *text, void * /* arg */)
+{
+  replies++;
+  replyLength = strlen(text);
+  replyLast = replyLength ? text[replyLength - 1] : 0;
+}
+
+/* allocations made by one getUpdates() fetching n updates */
+static uint32_t fetch(int n)
+{
+  char text[48];
+  int got;
+
+  for (int i = 0; i < n; i++) {
+    snprintf(text, sizeof(text), "/setTempHH 21.5 from the brew day %d", i);
+    hostTelegramMessage(CHAT, SENDER, text);
+  }
+  allocations = 0;
+  counting = true;
+  got = bot.getUpdates(bot.last_message_received + 1);
+  counting = false;
+  TEST_ASSERT_EQUAL_INT(n, got);
+  return allocations;
+}
+
+void setUp(void)
+{
+  replies = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_field_truncation(void)
+{
+  TelegramField<8> field;
+
+  field = "1234567";
+  TEST_ASSERT_FALSE(field.truncated());
+  field = "/status now";
+  TEST_ASSERT_TRUE(field.truncated());
+  TEST_ASSERT_EQUAL_STRING("/status", field.c_str());
+  /* cut at a character, not inside it */
+  field = "/temp \xC2\xB0" "C";
+  TEST_ASSERT_TRUE(field.truncated());
+  TEST_ASSERT_EQUAL_STRING("/temp ", field.c_str());
+  field = "";
+  TEST_ASSERT_FALSE(field.truncated());
+}
+
+/* an update costs no allocation of its own: the fields are fixed
+ * buffers and the stand-in builds its answer in one allocation, so a full
+ * batch takes as many as a single update. With String fields the texts
+ * and names took two or three each. */
+void test_allocations_per_update(void)
+{
+  uint32_t one, full;
+
+  fetch(BATCH);  /* first request: the filter, the connection and buffers */
+  one  = fetch(1);
+  full = fetch(BATCH);
+  TEST_MESSAGE(("allocations: " + String(one) + " for 1 update, " + String(full) +
+                " for " + String(BATCH)).c_str());
+  TEST_ASSERT_EQUAL_UINT32(one, full);
+  TEST_ASSERT_EQUAL_STRING(SENDER, bot.messages[BATCH - 1].from_name.c_str());
+}
+
+void test_long_message_dropped(void)
+{
+  String text = "/status";
+
+  while (text.length() < TELEGRAM_TEXT_SIZE) text += " padding";
+  hostTelegramMessage(CHAT, SENDER, text.c_str());
+  TEST_ASSERT_EQUAL_INT(1, bot.getUpdates(bot.last_message_received + 1));
+  TEST_ASSERT_TRUE(bot.messages[0].text.truncated());
+  handleNewMessages(1);
+  hostRun(1000);
+  TEST_ASSERT_EQUAL_UINT32(0, replies);
+
+  hostTelegramMessage(CHAT, SENDER, "/status");
+  TEST_ASSERT_EQUAL_INT(1, bot.getUpdates(bot.last_message_received + 1));
+  TEST_ASSERT_FALSE(bot.messages[0].text.truncated());
+  handleNewMessages(1);
+  hostRun(1000);
+  TEST_ASSERT_EQUAL_UINT32(1, replies);
+}
+
+/* the longest reply goes out whole */
+void test_start_fits(void)
+{
+  hostTelegramMessage(CHAT, SENDER, "/start");
+  TEST_ASSERT_EQUAL_INT(1, bot.getUpdates(bot.last_message_received + 1));
+  handleNewMessages(1);
+  hostRun(1000);
+  TEST_ASSERT_EQUAL_UINT32(1, replies);
+  TEST_ASSERT_GREATER_THAN(0, replyLength);
+  TEST_ASSERT_LESS_THAN(BOT_REPLY_SIZE - 1, replyLength);
+}
+
+/* a reply cut at BOT_REPLY_SIZE in the middle of a "°" loses all of it */
+void test_reply_cut_at_character(void)
+{
+  static char text[BOT_REPLY_SIZE + 8];
+
+  memset(text, 'a', BOT_REPLY_SIZE - 2);
+  strcpy(text + BOT_REPLY_SIZE - 2, "\xC2\xB0" "C");
+  TEST_ASSERT_TRUE(queueReply(CHAT, text, ""));
+  hostRun(1000);
+  TEST_ASSERT_EQUAL_UINT32(1, replies);
+  TEST_ASSERT_EQUAL_UINT32(BOT_REPLY_SIZE - 2, replyLength);
+  TEST_ASSERT_EQUAL_INT('a', replyLast);
+}
+
+int main(void)
+{
+  hostBegin();
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  hostRun(HOST_WIFI_DELAY + 100);
+  hostOnTelegramReply(onReply, NULL);
+  botSenderBegin(&bot);
+  xTaskCreate(vBotSenderTask, "botSend", 0x2000, NULL, 2, NULL);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_field_truncation);
+  RUN_TEST(test_allocations_per_update);
+  RUN_TEST(test_long_message_dropped);
+  RUN_TEST(test_start_fits);
+  RUN_TEST(test_reply_cut_at_character);
+  hostExit(UNITY_END());
+  return 0;
+}